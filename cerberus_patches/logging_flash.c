@@ -13,6 +13,47 @@
  */
 #define	LOGGING_FLASH_TERMINATOR	(1U << 15)
 
+/**
+ * Marker for a sector summary that has been written.
+ */
+#define	LOGGING_FLASH_SECTOR_SEALED	0x5EA1
+
+
+/**
+ * Compute the integrity check for a sector summary.
+ *
+ * @param summary The summary to check.
+ *
+ * @return The expected check value.
+ */
+static uint32_t logging_flash_summary_check (const struct logging_flash_sector_summary *summary)
+{
+	return ~(summary->first_entry_id ^ summary->next_entry_id ^
+		((uint32_t) summary->used << 16) ^ summary->sealed);
+}
+
+/**
+ * Write the summary for a sector that has been filled.  A failure is not reported since the
+ * sector is then scanned entry by entry on the next mount.
+ *
+ * @param logging The log that filled the sector.
+ * @param sector The sector that was filled.
+ */
+static void logging_flash_seal_sector (struct logging_flash *logging, uint8_t sector)
+{
+	struct logging_flash_sector_summary summary;
+
+	summary.first_entry_id = logging->sector_first_id;
+	summary.next_entry_id = logging->next_entry_id;
+	summary.used = logging->flash_used[sector];
+	summary.sealed = LOGGING_FLASH_SECTOR_SEALED;
+	summary.check = logging_flash_summary_check (&summary);
+
+	logging->flash->base.write (logging->flash,
+		logging->base_addr + (FLASH_SECTOR_SIZE * sector) + LOGGING_FLASH_SECTOR_DATA_LEN,
+		(uint8_t*) &summary, sizeof (summary));
+}
+
 
 /**
  * Save the entry buffer to flash.
@@ -43,6 +84,8 @@ static int logging_flash_save_buffer (struct logging_flash *logging)
 			}
 
 			logging->flash_used[curr_sector_num] = 0;
+			logging->sector_first_id =
+				((struct logging_entry_header*) logging->entry_buffer)->entry_id;
 
 			if (logging->log_start == curr_sector_num) {
 				int next_sector = (logging->log_start + 1) % LOGGING_FLASH_SECTORS;
@@ -73,10 +116,13 @@ static int logging_flash_save_buffer (struct logging_flash *logging)
 		logging->flash_used[curr_sector_num] += write_len;
 
 		if (status == 0) {
+			bool sealed = false;
+
 			if ((FLASH_SECTOR_OFFSET (logging->next_addr) != 0) &&
 				((logging->write_remain < (int) sizeof (struct logging_entry_header)) ||
 					logging->terminated)) {
 				logging->next_addr = FLASH_SECTOR_BASE (logging->next_addr) + FLASH_SECTOR_SIZE;
+				sealed = true;
 			}
 
 			if (logging->next_addr >= (logging->base_addr + LOGGING_FLASH_AREA_LEN)) {
@@ -85,11 +131,15 @@ static int logging_flash_save_buffer (struct logging_flash *logging)
 
 			logging->next_write = logging->entry_buffer;
 			logging->write_remain =
-				sizeof (logging->entry_buffer) - FLASH_SECTOR_OFFSET (logging->next_addr);
+				LOGGING_FLASH_SECTOR_DATA_LEN - FLASH_SECTOR_OFFSET (logging->next_addr);
 			if (logging->terminated) {
 				logging->flash_used[curr_sector_num] -= sizeof (struct logging_entry_header);
 				logging->terminated = false;
 			}
+
+			if (sealed) {
+				logging_flash_seal_sector (logging, curr_sector_num);
+			}
 		}
 		else {
 			/* The write was not fully complete, so move the remaining data to be at the beginning
@@ -133,7 +183,7 @@ static int logging_flash_create_entry (struct logging *logging, uint8_t *entry,
 	}
 
 	if ((length == 0) ||
-		((length + sizeof (struct logging_entry_header) > sizeof (flash_log->entry_buffer)))) {
+		((length + sizeof (struct logging_entry_header) > LOGGING_FLASH_SECTOR_DATA_LEN))) {
 		return LOGGING_BAD_ENTRY_LENGTH;
 	}
 
@@ -206,7 +256,7 @@ static int logging_flash_clear (struct logging *logging)
 
 	flash_log->next_addr = flash_log->base_addr;
 	flash_log->next_write = flash_log->entry_buffer;
-	flash_log->write_remain = sizeof (flash_log->entry_buffer);
+	flash_log->write_remain = LOGGING_FLASH_SECTOR_DATA_LEN;
 	flash_log->terminated = false;
 
 exit:
@@ -304,10 +354,84 @@ static int logging_flash_read_contents (struct logging *logging, uint32_t offset
 	return bytes_read;
 }
 
+/**
+ * Parse the entries of a sector that has no summary, either the sector still being written or a
+ * sector written before summaries were used.
+ *
+ * @param logging The log being initialized.  The entry buffer is used to hold the sector.
+ * @param flash The flash device where log entries are stored.
+ * @param addr The address of the sector.
+ * @param summary Output for the sector contents.  The sector is reported as sealed if no more
+ * entries can be added to it.
+ * @param end Output for the offset following the last entry in the sector.
+ *
+ * @return 0 if the sector was parsed successfully or an error code.
+ */
+static int logging_flash_scan_sector (struct logging_flash *logging, struct spi_flash *flash,
+	uint32_t addr, struct logging_flash_sector_summary *summary, uint32_t *end)
+{
+	uint8_t *pos = logging->entry_buffer;
+	uint8_t *buffer_end = logging->entry_buffer + sizeof (logging->entry_buffer);
+	bool first = true;
+	int status;
+
+	memset (summary, 0, sizeof (*summary));
+	*end = 0;
+
+	status = flash->base.read (flash, addr, logging->entry_buffer, sizeof (logging->entry_buffer));
+	if (status != 0) {
+		return status;
+	}
+
+	while ((buffer_end - pos) >= (int) sizeof (struct logging_entry_header)) {
+		struct logging_entry_header *header = (struct logging_entry_header*) pos;
+		int length = header->length & ~LOGGING_FLASH_TERMINATOR;
+
+		if (!LOGGING_IS_ENTRY_START (header->log_magic) ||
+			(LOGGING_HEADER_FORMAT (header->log_magic) == 0xA)) {
+			/* Anything but erased flash after the last entry can't be appended to. */
+			while (pos != buffer_end) {
+				if (*pos != 0xff) {
+					summary->sealed = LOGGING_FLASH_SECTOR_SEALED;
+					break;
+				}
+
+				pos++;
+			}
+			break;
+		}
+
+		if ((length > (buffer_end - pos)) ||
+			(length < (int) sizeof (struct logging_entry_header)) ||
+			(header->length & LOGGING_FLASH_TERMINATOR)) {
+			summary->sealed = LOGGING_FLASH_SECTOR_SEALED;
+			break;
+		}
+
+		if (first) {
+			summary->first_entry_id = header->entry_id;
+			first = false;
+		}
+		summary->next_entry_id = header->entry_id + 1;
+		summary->used += length;
+		*end += length;
+		pos += length;
+	}
+
+	if (((int) LOGGING_FLASH_SECTOR_DATA_LEN - (int) *end) < (int) sizeof (struct logging_entry_header)) {
+		summary->sealed = LOGGING_FLASH_SECTOR_SEALED;
+	}
+
+	return 0;
+}
+
 /**
  * Initialize a log that uses flash for persistent storage.  Log entries already on flash will be
  * detected and maintained.
  *
+ * Full sectors are mounted from their sector summaries, so only the sector still being written
+ * needs to be parsed entry by entry.
+ *
  * The log will consume an entire flash erase sector.
  *
  * @param logging The log to initialize.
@@ -319,13 +443,18 @@ static int logging_flash_read_contents (struct logging *logging, uint32_t offset
  */
 int logging_flash_init (struct logging_flash *logging, struct spi_flash *flash, uint32_t base_addr)
 {
+	struct logging_flash_sector_summary summary;
+	struct logging_entry_header header;
 	int curr_sector_num;
-	uint8_t *pos;
-	uint8_t *end;
+	int newest = -1;
+	int oldest = -1;
+	uint32_t oldest_id = 0;
 	uint32_t entry_id = 0;
-	uint32_t prev_entry_id = 0;
+	uint32_t end = 0;
+	uint32_t newest_end = 0;
+	bool newest_sealed = false;
+	uint32_t sector_addr;
 	uint32_t flash_addr;
-	int found_next = 0;
 	int status;
 
 	if ((logging == NULL) || (flash == NULL)) {
@@ -341,94 +470,65 @@ int logging_flash_init (struct logging_flash *logging, struct spi_flash *flash,
 
 	memset (logging, 0, sizeof (struct logging_flash));
 
-	flash_addr = base_addr;
-	end = logging->entry_buffer + sizeof (logging->entry_buffer);
-
 	for (curr_sector_num = 0; curr_sector_num < LOGGING_FLASH_SECTORS; ++curr_sector_num) {
-#if 0
-		status = spi_flash_read (flash, base_addr + (FLASH_SECTOR_SIZE * curr_sector_num),
-		logging->entry_buffer, sizeof (logging->entry_buffer));
-#else
-		status = flash->base.read  (flash, base_addr + (FLASH_SECTOR_SIZE * curr_sector_num),
-		logging->entry_buffer, sizeof (logging->entry_buffer));
-#endif
+		sector_addr = base_addr + (FLASH_SECTOR_SIZE * curr_sector_num);
+
+		status = flash->base.read (flash, sector_addr + LOGGING_FLASH_SECTOR_DATA_LEN,
+			(uint8_t*) &summary, sizeof (summary));
 		if (status != 0) {
 			return status;
 		}
 
-		pos = logging->entry_buffer;
-		while ((end - pos) >= (int) sizeof (struct logging_entry_header)) {
-			struct logging_entry_header *header = (struct logging_entry_header*) pos;
-
-			if (!LOGGING_IS_ENTRY_START (header->log_magic) ||
-				(LOGGING_HEADER_FORMAT (header->log_magic) == 0xA)) {
-				if (found_next == 0) {
-					if (FLASH_SECTOR_OFFSET (flash_addr) == 0) {
-						found_next = 1;
-					}
-					else {
-						bool blank = true;
-
-						while (pos != end) {
-							if (*pos != 0xff) {
-								blank = false;
-								break;
-							}
-
-							pos++;
-						}
-
-						if (!blank) {
-							flash_addr = FLASH_SECTOR_BASE (flash_addr) + FLASH_SECTOR_SIZE;
-						}
-						else {
-							found_next = 1;
-						}
-					}
-				}
-				break;
+		if ((summary.sealed == LOGGING_FLASH_SECTOR_SEALED) &&
+			(summary.check == logging_flash_summary_check (&summary)) &&
+			(summary.used <= LOGGING_FLASH_SECTOR_DATA_LEN)) {
+			end = LOGGING_FLASH_SECTOR_DATA_LEN;
+		}
+		else {
+			status = flash->base.read (flash, sector_addr, (uint8_t*) &header, sizeof (header));
+			if (status != 0) {
+				return status;
 			}
-			else {
-				int length = header->length & ~LOGGING_FLASH_TERMINATOR;
-
-				if ((length > (end - pos)) ||
-					(length < (int) sizeof (struct logging_entry_header))) {
-					if (found_next == 0) {
-						flash_addr = FLASH_SECTOR_BASE (flash_addr) + FLASH_SECTOR_SIZE;
-					}
-					break;
-				}
-
-				if (header->length & LOGGING_FLASH_TERMINATOR) {
-					if (found_next == 0) {
-						flash_addr = FLASH_SECTOR_BASE (flash_addr) + FLASH_SECTOR_SIZE;
-					}
-					break;
-				}
 
-				if (found_next < 2) {
-					entry_id = header->entry_id + 1;
-
-					if (prev_entry_id > entry_id) {
-						entry_id = prev_entry_id;
-						logging->log_start = curr_sector_num;
-						found_next = 2;
-					}
-					else if (found_next == 0) {
-						flash_addr += length;
-						prev_entry_id = entry_id;
-					}
-				}
+			if (!LOGGING_IS_ENTRY_START (header.log_magic) ||
+				(LOGGING_HEADER_FORMAT (header.log_magic) == 0xA)) {
+				continue;
+			}
 
-				logging->flash_used[curr_sector_num] += length;
-				pos += length;
+			status = logging_flash_scan_sector (logging, flash, sector_addr, &summary, &end);
+			if (status != 0) {
+				return status;
 			}
 		}
 
-		if ((FLASH_SECTOR_SIZE - FLASH_SECTOR_OFFSET (flash_addr)) <
-			sizeof (struct logging_entry_header)) {
-			flash_addr = FLASH_SECTOR_BASE (flash_addr) + FLASH_SECTOR_SIZE;
+		if (summary.used == 0) {
+			continue;
 		}
+
+		logging->flash_used[curr_sector_num] = summary.used;
+
+		if ((oldest < 0) || (summary.first_entry_id < oldest_id)) {
+			oldest = curr_sector_num;
+			oldest_id = summary.first_entry_id;
+		}
+
+		if ((newest < 0) || (summary.next_entry_id > entry_id)) {
+			newest = curr_sector_num;
+			entry_id = summary.next_entry_id;
+			newest_end = end;
+			newest_sealed = (summary.sealed == LOGGING_FLASH_SECTOR_SEALED);
+			logging->sector_first_id = summary.first_entry_id;
+		}
+	}
+
+	if (newest < 0) {
+		flash_addr = base_addr;
+	}
+	else if (newest_sealed) {
+		flash_addr = base_addr + (FLASH_SECTOR_SIZE * (newest + 1));
+	}
+	else {
+		flash_addr = base_addr + (FLASH_SECTOR_SIZE * newest) + newest_end;
 	}
 
 	if (flash_addr >= (base_addr + LOGGING_FLASH_AREA_LEN)) {
@@ -442,10 +542,11 @@ int logging_flash_init (struct logging_flash *logging, struct spi_flash *flash,
 
 	logging->flash = flash;
 	logging->base_addr = base_addr;
+	logging->log_start = (oldest < 0) ? 0 : oldest;
 	logging->next_addr = flash_addr;
 	logging->next_entry_id = entry_id;
 	logging->next_write = logging->entry_buffer;
-	logging->write_remain = sizeof (logging->entry_buffer) - FLASH_SECTOR_OFFSET (flash_addr);
+	logging->write_remain = LOGGING_FLASH_SECTOR_DATA_LEN - FLASH_SECTOR_OFFSET (flash_addr);
 
 	logging->base.create_entry = logging_flash_create_entry;
 	logging->base.flush = logging_flash_flush;
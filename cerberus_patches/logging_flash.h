@@ -23,6 +23,26 @@
 #define LOGGING_FLASH_SECTORS 		(LOGGING_FLASH_AREA_LEN / FLASH_SECTOR_SIZE)	// (8 * 1024) / (4 * 1024) = 2
 #endif
 
+#pragma pack(push, 1)
+/**
+ * Summary stored at the end of each log sector once the sector is full.  Mounting the log only
+ * needs these records and the sector that is still open, instead of parsing every entry.
+ */
+struct logging_flash_sector_summary {
+	uint32_t first_entry_id;		/**< ID of the first entry in the sector. */
+	uint32_t next_entry_id;			/**< ID following the last entry in the sector. */
+	uint16_t used;					/**< Number of valid log bytes in the sector. */
+	uint16_t sealed;				/**< Set to LOGGING_FLASH_SECTOR_SEALED when the sector is full. */
+	uint32_t check;					/**< Inverse of the other fields, detects torn summaries. */
+};
+#pragma pack(pop)
+
+/**
+ * Log bytes available in each sector, the rest of the sector holds the sector summary.
+ */
+#define	LOGGING_FLASH_SECTOR_DATA_LEN	\
+	(FLASH_SECTOR_SIZE - sizeof (struct logging_flash_sector_summary))
+
 /**
  * A log that will persistently store entries on flash.
  */
@@ -39,6 +59,7 @@ struct logging_flash {
 	uint32_t flash_used[LOGGING_FLASH_SECTORS];	/**< Number of valid bytes stored in each sector. */
 	uint32_t next_addr;							/**< Next flash address to write to. */
 	int log_start;								/**< The sector that contains the first entries. */
+	uint32_t sector_first_id;					/**< ID of the first entry in the sector being written. */
 };
 
 
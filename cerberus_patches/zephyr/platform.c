@@ -61,7 +61,8 @@ void* platform_realloc (void *ptr, size_t size)
 #define	PLATFORM_TIMEOUT_ERROR(code)		ROT_ERROR (ROT_MODULE_PLATFORM_TIMEOUT, code)
 
 /**
- * Initialize a clock structure to represent the time at which a timeout expires.
+ * Initialize a clock structure to represent the time at which a timeout expires.  The timeout is
+ * stored as an absolute deadline on the kernel uptime tick clock.
  *
  * @param msec The number of milliseconds to use for the timeout.
  * @param timeout The timeout clock to initialize.
@@ -70,13 +71,11 @@ void* platform_realloc (void *ptr, size_t size)
  */
 int platform_init_timeout (uint32_t msec, platform_clock *timeout)
 {
-	TickType_t now = 0; //xTaskGetTickCount ();
-
 	if (timeout == NULL) {
 		return PLATFORM_TIMEOUT_ERROR (INVALID_ARGUMENT);
 	}
 
-	timeout->ticks = now;
+	timeout->ticks = k_uptime_ticks ();
 	timeout->wrap = 0;
 
 	return platform_increase_timeout (msec, timeout);
@@ -92,18 +91,12 @@ int platform_init_timeout (uint32_t msec, platform_clock *timeout)
  */
 int platform_increase_timeout (uint32_t msec, platform_clock *timeout)
 {
-	TickType_t curr;
-
 	if (timeout == NULL) {
 		return PLATFORM_TIMEOUT_ERROR (INVALID_ARGUMENT);
 	}
 
-	curr = timeout->ticks;
-
-	timeout->ticks += msec / 1000;//portTICK_PERIOD_MS;
-	if ((timeout->wrap == 0) && (timeout->ticks < curr)) {
-		timeout->wrap = 1;
-	}
+	/* The 64-bit uptime tick counter does not wrap, so wrap is never set. */
+	timeout->ticks += k_ms_to_ticks_ceil64 (msec);
 
 	return 0;
 }
@@ -117,14 +110,12 @@ int platform_increase_timeout (uint32_t msec, platform_clock *timeout)
  */
 int platform_init_current_tick (platform_clock *currtime)
 {
-	TickType_t now = 0;//xTaskGetTickCount ();
-
 	if (currtime == NULL) {
 		return PLATFORM_TIMEOUT_ERROR (INVALID_ARGUMENT);
 	}
 
 	currtime->wrap = 0;
-	currtime->ticks = now;
+	currtime->ticks = k_uptime_ticks ();
 
 	return 0;
 }
@@ -138,28 +129,11 @@ int platform_init_current_tick (platform_clock *currtime)
  */
 int platform_has_timeout_expired (platform_clock *timeout)
 {
-	TickType_t now = 0; //xTaskGetTickCount ();
-
 	if (timeout == NULL) {
 		return PLATFORM_TIMEOUT_ERROR (INVALID_ARGUMENT);
 	}
 
-	if (!timeout->wrap) {
-		if (now < timeout->ticks) {
-			return 0;
-		}
-		else {
-			return 1;
-		}
-	}
-	else {
-		if ((now < 0xf0000000) && (now >= timeout->ticks)) {
-			return 1;
-		}
-		else {
-			return 0;
-		}
-	}
+	return (k_uptime_ticks () >= timeout->ticks) ? 1 : 0;
 }
 
 /**
@@ -169,34 +143,26 @@ int platform_has_timeout_expired (platform_clock *timeout)
  */
 uint64_t platform_get_time_since_boot (void)
 {
-	return (uint64_t) 1000; //xTaskGetTickCount () * portTICK_PERIOD_MS;
+	return (uint64_t) k_uptime_get ();
 }
 
 /**
  * Get the duration between two clock instances.  These are expected to be initialized with
  * {@link platform_init_current_tick}.
  *
- * This is intended to measure small durations.  Very long durations may not be accurately
- * calculated due value limitations/overflow.
- *
  * @param start The start time for the time duration.
  * @param end The end time for the time duration.
  *
- * @return The elapsed time, in milliseconds.  If either clock is null, the elapsed time will be 0.
+ * @return The elapsed time, in milliseconds.  If either clock is null or the end is before the
+ * start, the elapsed time will be 0.
  */
 uint32_t platform_get_duration (const platform_clock *start, const platform_clock *end)
 {
-	if ((end == NULL) || (start == NULL)) {
+	if ((end == NULL) || (start == NULL) || (end->ticks < start->ticks)) {
 		return 0;
 	}
 
-	if (start->ticks <= end->ticks) {
-		return (end->ticks - start->ticks) * 1000; //portTICK_PERIOD_MS;
-	}
-	else {
-		/* The ticks have wrapped. */
-		return ((portMAX_DELAY - start->ticks) + end->ticks) * 1000; //portTICK_PERIOD_MS;
-	}
+	return (uint32_t) k_ticks_to_ms_floor64 (end->ticks - start->ticks);
 }
 
 
@@ -250,13 +216,12 @@ int platform_mutex_free (platform_mutex *mutex)
  */
 int platform_mutex_lock (platform_mutex *mutex)
 {
-	k_timeout_t timeout = { portMAX_DELAY };
 	if (mutex == NULL) {
 		return PLATFORM_MUTEX_ERROR (INVALID_ARGUMENT);
 	}
 
 	//xSemaphoreTake (*mutex, portMAX_DELAY);
-	k_sem_take(mutex, timeout);
+	k_sem_take(mutex, K_FOREVER);
 	return 0;
 }
 
@@ -363,6 +328,26 @@ int platform_recursive_mutex_unlock (platform_mutex *mutex)
 
 #define	PLATFORM_TIMER_ERROR(code)		ROT_ERROR (ROT_MODULE_PLATFORM_TIMER, code)
 
+/**
+ * Deferred timer expiration handler.  Runs the callback from the system work queue, since the
+ * kernel timer expires in interrupt context.  The disarm lock is held across the callback so a
+ * timer disarmed from another thread never sees the callback run afterwards.
+ *
+ * @param work The work item of the timer that expired.
+ */
+static void platform_timer_work_handler (struct k_work *work)
+{
+	platform_timer *instance = CONTAINER_OF (work, platform_timer, work);
+
+	k_mutex_lock (&instance->disarm_lock, K_FOREVER);
+
+	if (!instance->disarm) {
+		instance->callback (instance->context);
+	}
+
+	k_mutex_unlock (&instance->disarm_lock);
+}
+
 /**
  * Internal notification function for timer expiration.
  *
@@ -370,18 +355,9 @@ int platform_recursive_mutex_unlock (platform_mutex *mutex)
  */
 static void platform_timer_notification (TimerHandle_t *timer)
 {
-	// TODO Need a Function to handle this
-	/*platform_timer *instance = pvTimerGetTimerID (timer);
+	platform_timer *instance = CONTAINER_OF (timer, platform_timer, timer);
 
-	if (instance) {
-		xSemaphoreTakeRecursive (instance->disarm_lock, portMAX_DELAY);
-
-		if (!instance->disarm) {
-			instance->callback (instance->context);
-		}
-
-		xSemaphoreGiveRecursive (instance->disarm_lock);
-	}*/
+	k_work_submit (&instance->work);
 }
 
 /**
@@ -401,17 +377,13 @@ int platform_timer_create (platform_timer *timer, timer_callback callback, void
 
 	//timer->disarm_lock = xSemaphoreCreateRecursiveMutex ();
 	//if (timer->disarm_lock == NULL) {
-	if(platform_recursive_mutex_lock(&(timer->disarm_lock))) {
+	if(k_mutex_init(&(timer->disarm_lock))) {
 		return PLATFORM_TIMER_ERROR (NO_MEMORY);
 	}
 
 	//timer->timer = xTimerCreate ("SWTimer", 1, pdFALSE, timer, platform_timer_notification);
 	k_timer_init(&(timer->timer), platform_timer_notification, NULL);
-	//if (timer->timer == NULL) {
-		//vSemaphoreDelete (timer->disarm_lock);
-	if(platform_recursive_mutex_unlock(&(timer->disarm_lock))) {
-		return PLATFORM_TIMER_ERROR (NO_MEMORY);
-	}
+	k_work_init(&(timer->work), platform_timer_work_handler);
 
 	timer->callback = callback;
 	timer->context = context;
@@ -436,19 +408,17 @@ int platform_timer_arm_one_shot (platform_timer *timer, uint32_t ms_timeout)
 	}
 
 	// xSemaphoreTakeRecursive (timer->disarm_lock, portMAX_DELAY);
-	if(platform_recursive_mutex_lock(&(timer->disarm_lock))) {
+	if(k_mutex_lock(&(timer->disarm_lock), K_FOREVER)) {
 		return PLATFORM_TIMER_ERROR (NO_MEMORY);
 	}
 
 	timer->disarm = 0;
 	/*xTimerChangePeriod (timer->timer, pdMS_TO_TICKS (ms_timeout), portMAX_DELAY);
 	xTimerReset (timer->timer, portMAX_DELAY);*/
-	k_timeout_t duration = { ms_timeout };
-	k_timeout_t period = { portMAX_DELAY };
-	k_timer_start(&(timer->timer), duration, period);
+	k_timer_start(&(timer->timer), K_MSEC (ms_timeout), K_NO_WAIT);
 
 	//xSemaphoreGiveRecursive (timer->disarm_lock);
-	if(platform_recursive_mutex_unlock(&(timer->disarm_lock))) {
+	if(k_mutex_unlock(&(timer->disarm_lock))) {
 		return PLATFORM_TIMER_ERROR (NO_MEMORY);
 	}
 	return 0;
@@ -468,7 +438,7 @@ int platform_timer_disarm (platform_timer *timer)
 	}
 
 	//xSemaphoreTakeRecursive (timer->disarm_lock, portMAX_DELAY);
-	if(platform_recursive_mutex_lock(&(timer->disarm_lock))) {
+	if(k_mutex_lock(&(timer->disarm_lock), K_FOREVER)) {
 		return PLATFORM_TIMER_ERROR (NO_MEMORY);
 	}
 
@@ -477,7 +447,7 @@ int platform_timer_disarm (platform_timer *timer)
 	k_timer_stop(&(timer->timer));
 
 	//xSemaphoreGiveRecursive (timer->disarm_lock);
-	if(platform_recursive_mutex_unlock(&(timer->disarm_lock))) {
+	if(k_mutex_unlock(&(timer->disarm_lock))) {
 		return PLATFORM_TIMER_ERROR (NO_MEMORY);
 	}
 
@@ -491,13 +461,16 @@ int platform_timer_disarm (platform_timer *timer)
  */
 void platform_timer_delete (platform_timer *timer)
 {
+	struct k_work_sync sync;
+
 	if (timer != NULL) {
 		platform_timer_disarm (timer);
 
-		platform_msleep (100);
+		/* An expiration may already have queued the callback, wait until it is gone. */
+		k_timer_stop (&(timer->timer));
+		k_work_cancel_sync (&(timer->work), &sync);
 		//xTimerDelete (timer->timer, portMAX_DELAY);
 		//vSemaphoreDelete (timer->disarm_lock);
-		platform_mutex_free(&(timer->disarm_lock));
 	}
 }
 
@@ -36,11 +36,11 @@ uint16_t platform_htons (uint16_t host_short);
 
 /* FreeRTOS sleep and system time. */
 //#define	platform_msleep(x)	vTaskDelay (pdMS_TO_TICKS (x) + 1)
-#define	platform_msleep(x)	sleep (x + 1)
+#define	platform_msleep(x)	k_msleep (x)
 
 typedef struct {
-	TickType_t ticks;
-	uint8_t wrap;
+	TickType_t ticks;		/**< Kernel uptime ticks, the absolute deadline for a timeout. */
+	uint8_t wrap;			/**< Unused, the 64-bit uptime tick counter does not wrap. */
 } platform_clock;
 
 int platform_init_timeout (uint32_t msec, platform_clock *timeout);
@@ -68,7 +68,8 @@ int platform_recursive_mutex_unlock (platform_mutex *mutex);
 typedef void (*timer_callback) (void *context);
 typedef struct {
 	TimerHandle_t timer;
-	struct k_sem disarm_lock;
+	struct k_work work;
+	struct k_mutex disarm_lock;	/**< Recursive, the callback may arm or disarm its own timer. */
 	timer_callback callback;
 	void *context;
 	uint8_t disarm;
@@ -26,6 +26,7 @@ uint8_t gI2CReadFlag;
 uint8_t gDataReceived;
 EVENT_CONTEXT I2CData;
 AO_DATA I2CActiveObjectData;
+static uint8_t gI2cTxBuf[1];
 /*	* I2c slave device callback function.
  * there are 5 callback function need to creat and link into I2c slave device when initial I2c device as slave device
  * and callback function structure is
@@ -158,3 +159,70 @@ struct i2c_slave_callbacks i2c_1060_callbacks_bmc = {
 	.read_processed = i2c_1060_slave_bmc_read_processed,
 	.stop = i2c_1060_slave_bmc_stop,
 };
+
+/*	* i2c_1060_slave_bmc_write_done
+ * transaction callback for I2C_1, called once per master write in DMA and buffer mode
+ *
+ * in I2C write byte protcol, buf holds mailbox register address and mailbox command
+ * in I2C read byte protcol, buf only holds mailbox register address and read_buffer follows
+ *
+ * @param config i2c_slave_config
+ *               buf    data received from master device
+ *               len    number of bytes received
+ *
+ * @return 0
+ */
+int i2c_1060_slave_bmc_write_done(struct i2c_slave_config *config, uint8_t *buf, uint32_t len)
+{
+	gI2cSlaveProcess.DataBuf[SLAVE_BUF_INDEX0] = buf[SLAVE_BUF_INDEX0];
+	gI2cSlaveProcess.operation = MASTER_DATA_READ_SLAVE_DATA_SEND;
+	gBmcFlag = TRUE;
+
+	if (len < 2)
+		return 0;
+
+	gI2cSlaveProcess.DataBuf[SLAVE_BUF_INDEX1] = buf[SLAVE_BUF_INDEX1];
+	gI2cSlaveProcess.InProcess = I2CInProcess_Flag;
+
+	I2CActiveObjectData.ProcessNewCommand = 1;
+	I2CActiveObjectData.type = I2C_EVENT;
+
+	I2CData.operation = I2C_HANDLE;
+	I2CData.i2c_data = gI2cSlaveProcess.DataBuf;
+	post_smc_action(I2C, &I2CActiveObjectData, &I2CData);
+	gDataReceived = 0;
+
+	return 0;
+}
+
+/*	* i2c_1060_slave_bmc_read_buffer
+ * transaction callback for I2C_1, loads the whole read response in DMA and buffer mode
+ *
+ * @param config i2c_slave_config
+ *               buf    pointer to store response buffer
+ *               len    pointer to store response length
+ *
+ * @return 0
+ */
+int i2c_1060_slave_bmc_read_buffer(struct i2c_slave_config *config, uint8_t **buf, uint32_t *len)
+{
+	*len = 0;
+	if (gI2cSlaveProcess.operation == MASTER_DATA_READ_SLAVE_DATA_SEND) {
+		gI2CReadFlag = TRUE;
+		gBmcFlag = TRUE;
+		gI2cTxBuf[0] = PchBmcCommands(gI2cSlaveProcess.DataBuf, gI2CReadFlag);
+		*buf = gI2cTxBuf;
+		*len = sizeof(gI2cTxBuf);
+	}
+	gDataReceived = 0;
+	ClearI2cSlaveProcessData();
+	return 0;
+}
+
+/*	* i2c_1060_xfer_callbacks_bmc
+ * transaction callback function for I2C_1
+ */
+const struct i2c_aspeed_slave_xfer_callbacks i2c_1060_xfer_callbacks_bmc = {
+	.write_done = i2c_1060_slave_bmc_write_done,
+	.read_buffer = i2c_1060_slave_bmc_read_buffer,
+};
@@ -8,6 +8,8 @@
 #include "Smbus_mailbox.h"
 #include <Common.h>
 #include "Definition.h"
+#include "boot_profile/boot_profile.h"
+#include "keystore/KeystoreManager.h"
 #ifdef CONFIG_INTEL_PFR_SUPPORT
 #include "intel_2.0/intel_pfr_pfm_manifest.h"
 #include "intel_2.0/intel_pfr_definitions.h"
@@ -67,6 +69,15 @@ CPLD_STATUS cpld_update_status;
 EVENT_CONTEXT UpdateEventData;
 AO_DATA UpdateActiveObject;
 
+/*
+ * RAM image of the provisioning UFM (offsets, root key hash, SVN and key cancellation policies).
+ * It is loaded with one bulk read and refreshed from the read-back done by every provisioning
+ * write, so readers of the provisioning data never go to the internal flash.
+ */
+static uint8_t provision_shadow[PROVISION_SHADOW_SIZE];
+static bool provision_shadow_loaded;
+static uint32_t provision_generation;
+
 
 void ResetMailBox(void)
 {
@@ -86,23 +97,95 @@ unsigned char erase_provision_flash(void)
 	int status;
 	struct SpiEngine *spi_flash = getSpiEngineWrapper();
 	spi_flash->spi.device_id[0] = ROT_INTERNAL_INTEL_STATE;
+	keystore_cache_invalidate();
+	provision_shadow_invalidate();
 	status = spi_flash->spi.base.sector_erase(&spi_flash->spi, 0);
 	return status;
 }
+
+/**
+    Function to load the provisioning UFM shadow with a single read
+
+    @Param  NULL
+    @retval int     Success or Failure
+ **/
+int provision_shadow_load(void)
+{
+	int status;
+	struct SpiEngine *spi_flash = getSpiEngineWrapper();
+
+	provision_shadow_loaded = false;
+	spi_flash->spi.device_id[0] = ROT_INTERNAL_INTEL_STATE; // Internal UFM SPI
+	status = spi_flash->spi.base.read(&spi_flash->spi, 0, provision_shadow, sizeof(provision_shadow));
+	if (status != Success)
+		return Failure;
+
+	provision_shadow_loaded = true;
+	return Success;
+}
+
+/**
+    Function to drop the provisioning UFM shadow, it is reloaded on the next read
+
+    @Param  NULL
+    @retval NULL
+ **/
+void provision_shadow_invalidate(void)
+{
+	provision_shadow_loaded = false;
+	provision_generation++;
+}
+
+/**
+    Function to get the provisioning generation, it changes every time the provisioning UFM is
+    erased or rewritten so results derived from provisioning data can be dropped
+
+    @Param  NULL
+    @retval uint32_t    Provisioning generation
+ **/
+uint32_t provision_shadow_generation(void)
+{
+	return provision_generation;
+}
+
+/**
+    Function to get provisioning data from the shadow
+
+    @Param  addr    Provisioning UFM offset
+    @Param  length  Number of bytes
+    @retval Pointer into the shadow, NULL if the range is not shadowed or cannot be loaded
+ **/
+uint8_t *provision_shadow_get(uint32_t addr, uint32_t length)
+{
+	if (addr >= PROVISION_SHADOW_SIZE || length > (PROVISION_SHADOW_SIZE - addr))
+		return NULL;
+
+	if (!provision_shadow_loaded && provision_shadow_load() != Success)
+		return NULL;
+
+	return &provision_shadow[addr];
+}
 /**
     Function to Initialize Smbus Mailbox with default value
 
     @Param  NULL
     @retval NULL
  **/
-void get_provision_data_in_flash(uint32_t addr, uint8_t *DataBuffer, uint32_t length)
+unsigned char get_provision_data_in_flash(uint32_t addr, uint8_t *DataBuffer, uint32_t length)
 {
 	uint8_t status;
+	uint8_t *shadow = provision_shadow_get(addr, length);
 	struct SpiEngine *spi_flash = getSpiEngineWrapper();
 
+	if (shadow != NULL) {
+		memcpy(DataBuffer, shadow, length);
+		return Success;
+	}
+
 	spi_flash->spi.device_id[0] = ROT_INTERNAL_INTEL_STATE; // Internal UFM SPI
 	status = spi_flash->spi.base.read(&spi_flash->spi, addr, DataBuffer, length);
 
+	return status;
 }
 
 unsigned char set_provision_data_in_flash(uint8_t addr, uint8_t *DataBuffer, uint8_t DataSize)
@@ -133,6 +216,11 @@ unsigned char set_provision_data_in_flash(uint8_t addr, uint8_t *DataBuffer, uin
 
 	spi_flash->spi.device_id[0] = ROT_INTERNAL_INTEL_STATE;
 	status = spi_flash->spi.base.read(&spi_flash->spi, 0, buffer, sizeof(buffer) / sizeof(buffer[0]));
+	// Refresh the shadow from what is now in flash
+	if (status == Success) {
+		memcpy(provision_shadow, buffer, sizeof(provision_shadow));
+		provision_shadow_loaded = true;
+	}
 
 	return status;
 }
@@ -158,6 +246,9 @@ void InitializeSmbusMailbox(void)
 	SetCpldReleaseVersion(CPLD_RELEASE_VERSION);
 	uint8_t CurrentSvn = 0;
 
+	// One bulk read, every provisioning lookup below and at runtime is served from RAM
+	provision_shadow_load();
+
 	// get root key hash
 	get_provision_data_in_flash(ROOT_KEY_HASH, gRootKeyHash, SHA256_DIGEST_LENGTH);
 	get_provision_data_in_flash(PCH_ACTIVE_PFM_OFFSET, gPchOffsets, sizeof(gPchOffsets));
@@ -1160,6 +1251,7 @@ bool WatchDogTimer(int ImageType)
 }
 
 static unsigned int mailBox_index;
+static unsigned int boot_profile_index;
 uint8_t PchBmcCommands(unsigned char *CipherText, uint8_t ReadFlag)
 {
 
@@ -1298,6 +1390,26 @@ uint8_t PchBmcCommands(unsigned char *CipherText, uint8_t ReadFlag)
 		break;
 	case CpldFPGARoTHash:
 		break;
+	case BootProfilePhaseCount:
+		// Reading the phase count rewinds the BootProfileData stream
+		if (ReadFlag == TRUE) {
+			DataToSend = boot_profile_phase_count();
+			boot_profile_index = 0;
+		}
+		break;
+	case BootProfileTotalLow:
+		// Total boot time in ms, saturated at 0xffff
+		if (ReadFlag == TRUE)
+			DataToSend = MIN(boot_profile_total_ms(), 0xffff) & 0xff;
+		break;
+	case BootProfileTotalHigh:
+		if (ReadFlag == TRUE)
+			DataToSend = MIN(boot_profile_total_ms(), 0xffff) >> 8;
+		break;
+	case BootProfileData:
+		if (ReadFlag == TRUE)
+			DataToSend = boot_profile_read_byte(boot_profile_index++);
+		break;
 	case AcmBiosScratchPad:
 		break;
 	case BmcScratchPad:
@@ -163,6 +163,10 @@ typedef enum _SMBUS_MAILBOX_RF_ADDRESS_READONLY {
 	BmcPFMRecoverMinorVersion,
 	CpldFPGARoTHash,
 	Reserved                = 0x63,
+	BootProfilePhaseCount   = 0x70,
+	BootProfileTotalLow,
+	BootProfileTotalHigh,
+	BootProfileData,
 	AcmBiosScratchPad       = 0x80,
 	BmcScratchPad           = 0xc0,
 } SMBUS_MAILBOX_RF_ADDRESS;
@@ -218,8 +222,14 @@ typedef struct _PFM_STRUCTURE {
 
 static SMBUS_MAIL_BOX gSmbusMailboxData = { 0 };
 
+#define PROVISION_SHADOW_SIZE	256	// Provisioning UFM bytes kept in RAM
+
 unsigned char set_provision_data_in_flash(uint8_t addr, uint8_t *DataBuffer, uint8_t DataSize);
-void get_provision_data_in_flash(uint32_t addr, uint8_t *DataBuffer, uint32_t length);
+unsigned char get_provision_data_in_flash(uint32_t addr, uint8_t *DataBuffer, uint32_t length);
+int provision_shadow_load(void);
+void provision_shadow_invalidate(void);
+uint32_t provision_shadow_generation(void);
+uint8_t *provision_shadow_get(uint32_t addr, uint32_t length);
 // void ReadFullUFM(uint32_t UfmId,uint32_t UfmLocation,uint8_t *DataBuffer, uint16_t DataSize);
 unsigned char erase_provision_data_in_flash(void);
 void GetUpdateStatus(uint8_t *DataBuffer, uint8_t DataSize);
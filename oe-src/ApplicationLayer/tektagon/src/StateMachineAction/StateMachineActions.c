@@ -19,6 +19,8 @@
 #include "SpiFilter/SpiFilter.h"
 #include "logging/debug_log.h"// State Machine log saving
 #include <gpio/gpio_aspeed.h>
+#include <abr/abr_aspeed.h>
+#include "boot_profile/boot_profile.h"
 
 
 #ifdef CONFIG_INTEL_PFR_SUPPORT
@@ -27,6 +29,8 @@
 #include "intel_2.0/intel_pfr_authentication.h"
 #include "intel_2.0/intel_pfr_definitions.h"
 #include "intel_2.0/intel_pfr_spi_filtering.h"
+#include "intel_2.0/intel_pfr_measurement_cache.h"
+#include "intel_2.0/intel_pfr_capsule_verdict.h"
 #endif
 
 #ifdef CONFIG_CERBERUS_PFR_SUPPORT
@@ -250,7 +254,9 @@ void PublishInitialEvents(void)
 	byte provision_state = get_provision_status();
 
 	if (provision_state == UFM_PROVISIONED) {
+		boot_profile_phase_begin(BOOT_PHASE_STAGING_CHECK);
 		check_staging_area();
+		boot_profile_phase_end(BOOT_PHASE_STAGING_CHECK);
 #if BMC_SUPPORT
 		PublishBmcEvents();
 #else
@@ -260,6 +266,15 @@ void PublishInitialEvents(void)
 		// T0
 		int releaseBmc = 1;
 		int releasePCH = 1;
+#if MEASUREMENT_CACHE_SUPPORT
+		// SPI filter is left open while unprovisioned, sealed measurements can't be trusted
+		measurement_cache_invalidate(BMC_TYPE);
+		measurement_cache_invalidate(PCH_TYPE);
+#endif
+#if CAPSULE_VERDICT_SUPPORT
+		capsule_verdict_invalidate(BMC_TYPE);
+		capsule_verdict_invalidate(PCH_TYPE);
+#endif
 		Set_SPI_Filter_RW_Region("spi_m1", SPI_FILTER_WRITE_PRIV, SPI_FILTER_PRIV_ENABLE, 0x0, 0x08000000);
 		T0Transition(releaseBmc, releasePCH);
 	}
@@ -409,6 +424,8 @@ int handleImageVerification(void *AoData, void *EventContext)
 			printk("Power Reset to BMCBootHold for Verify\n");
 			BMCBootHold();
 		 	PCHBootHold();
+			// The hosts must be in reset before their flash is accessed
+			BootHoldReleaseWait();
 		}
 		status = authentication_image(AoData, EventContext);
 		imageType = ActiveObjectData->type;
@@ -581,6 +598,8 @@ int handleRecoveryAction(void *AoData, void *EventContext)
 			printk("PowerOn Timeout to BMCBootHold for Recovery\n");
 			BMCBootHold();
 		 	PCHBootHold();
+			// The hosts must be in reset before their flash is accessed
+			BootHoldReleaseWait();
 		}
 		status = recover_image(AoData, EventContext);
 
@@ -779,6 +798,7 @@ void T0Transition(int releaseBmc, int releasePCH)
 {
 	int provision_status;
 
+	boot_profile_phase_begin(BOOT_PHASE_RELEASE);
 	SetPlatformState(ENTER_T0);
 	
 	provision_status = get_provision_status();
@@ -801,6 +821,13 @@ void T0Transition(int releaseBmc, int releasePCH)
 	if (releasePCH) {
 		PCHBootRelease();
 	}
+	boot_profile_phase_end(BOOT_PHASE_RELEASE);
+	boot_profile_complete();
+
+#if ROT_AB_UPDATE_SUPPORT
+	// Reached T0, keep the RoT slot we booted from
+	abr_boot_confirm();
+#endif
 }
 
 /**
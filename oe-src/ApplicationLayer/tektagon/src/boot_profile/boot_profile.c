@@ -0,0 +1,223 @@
+//***********************************************************************//
+//*                                                                     *//
+//*                      Copyright © 2022 AMI                           *//
+//*                                                                     *//
+//*        All rights reserved. Subject to AMI licensing agreement.     *//
+//*                                                                     *//
+//***********************************************************************//
+
+#include <zephyr.h>
+#include <string.h>
+#include <stdbool.h>
+#include "boot_profile.h"
+#include <Flash/FlashWrapper.h>
+#include <Crypto/HashWrapper.h>
+#ifdef CONFIG_SHELL
+#include <shell/shell.h>
+#endif
+
+#if BOOT_PROFILE_SUPPORT
+
+#define BOOT_PROFILE_STACK_DEPTH 4
+
+static const char *const boot_phase_name[BOOT_PHASE_MAX] = {
+	[BOOT_PHASE_IDLE] = "idle",
+	[BOOT_PHASE_ENGINE_INIT] = "engine init",
+	[BOOT_PHASE_MANIFEST_INIT] = "manifest init",
+	[BOOT_PHASE_DEBUG_INIT] = "debug init",
+	[BOOT_PHASE_BOOT_HOLD] = "boot hold",
+	[BOOT_PHASE_MAILBOX_INIT] = "mailbox init",
+	[BOOT_PHASE_STAGING_CHECK] = "staging check",
+	[BOOT_PHASE_VERIFY] = "verify",
+	[BOOT_PHASE_RECOVERY] = "recovery",
+	[BOOT_PHASE_RELEASE] = "release",
+};
+
+static struct boot_phase_record boot_phase_table[BOOT_PHASE_MAX];
+static uint8_t phase_stack[BOOT_PROFILE_STACK_DEPTH];
+static uint8_t phase_depth;
+static uint32_t phase_entered;
+static bool profile_running;
+static uint32_t total_us;
+
+static uint64_t cycle_wrap_us;
+static uint32_t main_cycles;
+static int64_t main_ticks;
+static uint32_t last_cycles;
+static int64_t last_ticks;
+static uint32_t last_spi_bytes;
+static uint32_t last_hash_bytes;
+
+/**
+ * Get the time elapsed since a reference point.  The 32-bit cycle counter is used for resolution,
+ * but it wraps after a few seconds, so the 64-bit tick clock is used once the interval gets close
+ * to the wrap period.
+ */
+static uint64_t elapsed_us_since(uint32_t cycles, int64_t ticks)
+{
+	uint64_t tick_us = k_ticks_to_us_floor64(k_uptime_ticks() - ticks);
+
+	if (tick_us >= (cycle_wrap_us / 2))
+		return tick_us;
+
+	return k_cyc_to_us_floor64(k_cycle_get_32() - cycles);
+}
+
+/**
+ * Charge everything since the last phase switch to the phase on top of the stack.
+ */
+static void boot_profile_charge(void)
+{
+	struct boot_phase_record *record = &boot_phase_table[phase_stack[phase_depth - 1]];
+	uint32_t spi_bytes = Wrapper_spi_flash_transferred_bytes();
+	uint32_t hash_bytes = HashEngineBytesProcessed();
+
+	record->elapsed_us += (uint32_t)elapsed_us_since(last_cycles, last_ticks);
+	record->spi_bytes += spi_bytes - last_spi_bytes;
+	record->hash_bytes += hash_bytes - last_hash_bytes;
+
+	last_cycles = k_cycle_get_32();
+	last_ticks = k_uptime_ticks();
+	last_spi_bytes = spi_bytes;
+	last_hash_bytes = hash_bytes;
+}
+
+/**
+ * Start boot profiling.  Must be called first thing in main().
+ */
+void boot_profile_start(void)
+{
+	memset(boot_phase_table, 0, sizeof(boot_phase_table));
+	cycle_wrap_us = k_cyc_to_us_floor64(UINT32_MAX);
+	main_cycles = last_cycles = k_cycle_get_32();
+	main_ticks = last_ticks = k_uptime_ticks();
+	last_spi_bytes = Wrapper_spi_flash_transferred_bytes();
+	last_hash_bytes = HashEngineBytesProcessed();
+
+	phase_stack[0] = BOOT_PHASE_IDLE;
+	phase_depth = 1;
+	phase_entered = BIT(BOOT_PHASE_IDLE);
+	total_us = 0;
+	profile_running = true;
+}
+
+/**
+ * Enter a boot phase.  Phases nest; time spent in a nested phase is not charged to the outer one.
+ *
+ * @param phase The phase being entered.
+ */
+void boot_profile_phase_begin(enum boot_phase phase)
+{
+	if (!profile_running || (phase <= BOOT_PHASE_IDLE) || (phase >= BOOT_PHASE_MAX))
+		return;
+
+	boot_profile_charge();
+	if (phase_depth < BOOT_PROFILE_STACK_DEPTH)
+		phase_stack[phase_depth++] = phase;
+
+	if (!(phase_entered & BIT(phase))) {
+		phase_entered |= BIT(phase);
+		boot_phase_table[phase].start_us = (uint32_t)elapsed_us_since(main_cycles, main_ticks);
+	}
+}
+
+/**
+ * Leave a boot phase.  Any phases nested inside it that were not closed are closed as well.
+ *
+ * @param phase The phase being left.
+ */
+void boot_profile_phase_end(enum boot_phase phase)
+{
+	uint8_t i;
+
+	if (!profile_running)
+		return;
+
+	for (i = phase_depth - 1; i > 0; i--) {
+		if (phase_stack[i] == phase) {
+			boot_profile_charge();
+			phase_depth = i;
+			return;
+		}
+	}
+}
+
+/**
+ * Stop profiling once the platform has been released and dump the table to the console.  Later
+ * verification, recovery and update passes at runtime are not recorded.
+ */
+void boot_profile_complete(void)
+{
+	if (!profile_running)
+		return;
+
+	boot_profile_charge();
+	phase_depth = 1;
+	total_us = (uint32_t)elapsed_us_since(main_cycles, main_ticks);
+	profile_running = false;
+
+	boot_profile_dump();
+}
+
+/**
+ * Print the boot phase table on the console.
+ */
+void boot_profile_dump(void)
+{
+	int i;
+
+	printk("Boot profile: %s, total %u ms\r\n", profile_running ? "in progress" : "complete",
+	       boot_profile_total_ms());
+	printk("  phase: start(us) elapsed(us) spi(bytes) hash(bytes)\r\n");
+	for (i = 0; i < BOOT_PHASE_MAX; i++) {
+		if (!(phase_entered & BIT(i)))
+			continue;
+
+		printk("  %s: %u %u %u %u\r\n", boot_phase_name[i],
+		       boot_phase_table[i].start_us, boot_phase_table[i].elapsed_us,
+		       boot_phase_table[i].spi_bytes, boot_phase_table[i].hash_bytes);
+	}
+}
+
+/**
+ * Get the number of records in the boot phase table.
+ */
+uint8_t boot_profile_phase_count(void)
+{
+	return BOOT_PHASE_MAX;
+}
+
+/**
+ * Get the time from main() to platform release, or 0 if the platform has not been released yet.
+ */
+uint32_t boot_profile_total_ms(void)
+{
+	return total_us / 1000;
+}
+
+/**
+ * Read one byte of the serialized boot phase table.
+ *
+ * @param index Byte offset into the table.
+ *
+ * @return The table byte, or 0 past the end of the table.
+ */
+uint8_t boot_profile_read_byte(uint32_t index)
+{
+	if (index >= sizeof(boot_phase_table))
+		return 0;
+
+	return ((uint8_t *)boot_phase_table)[index];
+}
+
+#ifdef CONFIG_SHELL
+static int cmd_boot_profile(const struct shell *shell, size_t argc, char **argv)
+{
+	boot_profile_dump();
+	return 0;
+}
+
+SHELL_CMD_REGISTER(boot_profile, NULL, "Dump per-phase boot timing", cmd_boot_profile);
+#endif
+
+#endif /* BOOT_PROFILE_SUPPORT */
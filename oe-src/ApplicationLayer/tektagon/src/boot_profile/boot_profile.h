@@ -0,0 +1,68 @@
+//***********************************************************************//
+//*                                                                     *//
+//*                      Copyright © 2022 AMI                           *//
+//*                                                                     *//
+//*        All rights reserved. Subject to AMI licensing agreement.     *//
+//*                                                                     *//
+//***********************************************************************//
+
+#ifndef BOOT_PROFILE_H_
+#define BOOT_PROFILE_H_
+
+#include <stdint.h>
+
+#ifndef BOOT_PROFILE_SUPPORT
+#define BOOT_PROFILE_SUPPORT 1
+#endif
+
+/**
+ * Boot phases tracked between main() and platform release.  BOOT_PHASE_IDLE is always at the
+ * bottom of the phase stack and absorbs any time not claimed by a named phase, so the sum of all
+ * phases equals the total boot time.
+ */
+enum boot_phase {
+	BOOT_PHASE_IDLE = 0,
+	BOOT_PHASE_ENGINE_INIT,
+	BOOT_PHASE_MANIFEST_INIT,
+	BOOT_PHASE_DEBUG_INIT,
+	BOOT_PHASE_BOOT_HOLD,
+	BOOT_PHASE_MAILBOX_INIT,
+	BOOT_PHASE_STAGING_CHECK,
+	BOOT_PHASE_VERIFY,
+	BOOT_PHASE_RECOVERY,
+	BOOT_PHASE_RELEASE,
+	BOOT_PHASE_MAX
+};
+
+/**
+ * Per-phase record, also the layout streamed out through the BootProfileData mailbox register.
+ * All fields are little endian.
+ */
+struct boot_phase_record {
+	uint32_t start_us;		/**< First entry into the phase, relative to main(). */
+	uint32_t elapsed_us;		/**< Time spent in the phase, excluding nested phases. */
+	uint32_t spi_bytes;		/**< Bytes read from or written to SPI flash in the phase. */
+	uint32_t hash_bytes;		/**< Bytes fed to the hash engine in the phase. */
+};
+
+#if BOOT_PROFILE_SUPPORT
+void boot_profile_start(void);
+void boot_profile_phase_begin(enum boot_phase phase);
+void boot_profile_phase_end(enum boot_phase phase);
+void boot_profile_complete(void);
+void boot_profile_dump(void);
+uint8_t boot_profile_phase_count(void);
+uint32_t boot_profile_total_ms(void);
+uint8_t boot_profile_read_byte(uint32_t index);
+#else
+static inline void boot_profile_start(void) {}
+static inline void boot_profile_phase_begin(enum boot_phase phase) {}
+static inline void boot_profile_phase_end(enum boot_phase phase) {}
+static inline void boot_profile_complete(void) {}
+static inline void boot_profile_dump(void) {}
+static inline uint8_t boot_profile_phase_count(void) { return 0; }
+static inline uint32_t boot_profile_total_ms(void) { return 0; }
+static inline uint8_t boot_profile_read_byte(uint32_t index) { return 0; }
+#endif
+
+#endif /* BOOT_PROFILE_H_ */
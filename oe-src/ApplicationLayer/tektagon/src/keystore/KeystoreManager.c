@@ -9,6 +9,7 @@
  * This file contains the KeyStore functions
  */
 
+#include <stdbool.h>
 #include "KeystoreManager.h"
 #include "Definition.h"
 #include <Common.h>
@@ -17,6 +18,174 @@
 #include "pfr/pfr_ufm.h"
 #include "pfr/pfr_util.h"
 
+/*
+ * Parsed public keys read from the RoT internal flash, keyed by the flash device and offset they
+ * were loaded from.  Any write to the keystore drops the whole cache.
+ */
+static struct Keystore_Cache_Entry key_cache[KEY_CACHE_ENTRIES];
+static uint8_t key_cache_next;
+
+/**
+ * Look up a public key in the key cache.
+ *
+ * @param flash_id Flash device the key is stored on.
+ * @param address Offset of the key on the flash device.
+ * @param pub_key Output for the cached key.
+ *
+ * @return Success if the key was cached or KEYSTORE_NO_KEY.
+ */
+int keystore_cache_get_public_key(uint8_t flash_id, uint32_t address, struct rsa_public_key *pub_key)
+{
+	int i;
+
+	for (i = 0; i < KEY_CACHE_ENTRIES; i++) {
+		if (key_cache[i].valid && (key_cache[i].flash_id == flash_id) && (key_cache[i].address == address)) {
+			memcpy(pub_key, &key_cache[i].pub_key, sizeof(struct rsa_public_key));
+			return Success;
+		}
+	}
+
+	return KEYSTORE_NO_KEY;
+}
+
+/**
+ * Add a public key that was just loaded from flash to the key cache.  The oldest entry is
+ * replaced when the cache is full.
+ *
+ * @param flash_id Flash device the key is stored on.
+ * @param address Offset of the key on the flash device.
+ * @param pub_key The parsed key.
+ */
+void keystore_cache_put_public_key(uint8_t flash_id, uint32_t address, const struct rsa_public_key *pub_key)
+{
+	struct Keystore_Cache_Entry *entry = &key_cache[key_cache_next];
+
+	key_cache_next = (key_cache_next + 1) % KEY_CACHE_ENTRIES;
+
+	entry->flash_id = flash_id;
+	entry->address = address;
+	memcpy(&entry->pub_key, pub_key, sizeof(struct rsa_public_key));
+	entry->valid = 1;
+}
+
+/**
+ * Drop all cached public keys.  Must be called whenever a key store area is written or erased.
+ */
+void keystore_cache_invalidate(void)
+{
+	memset(key_cache, 0, sizeof(key_cache));
+	key_cache_next = 0;
+}
+
+/*
+ * RAM directory of the key slots on ROT_INTERNAL_KEY.  It is built from flash the first time a
+ * keystore manager is initialized and kept in step by save and erase, so lookups by key content
+ * only probe a hash index and read the one candidate slot back from flash to confirm the match.
+ */
+static struct Keystore_Directory_Entry key_directory[KEY_MAX_NUMBER];
+static int16_t key_index[KEY_INDEX_SIZE];
+static bool key_directory_loaded;
+
+static uint32_t keystore_key_digest(const uint8_t *key)
+{
+	uint32_t digest = 2166136261u;	// FNV-1a
+	int i;
+
+	for (i = 0; i < KEY_MAX_LENGTH; i++) {
+		digest ^= key[i];
+		digest *= 16777619u;
+	}
+
+	return digest;
+}
+
+static void keystore_index_insert(int slot)
+{
+	uint32_t bucket = key_directory[slot].digest & (KEY_INDEX_SIZE - 1);
+
+	while (key_index[bucket] >= 0)
+		bucket = (bucket + 1) & (KEY_INDEX_SIZE - 1);
+
+	key_index[bucket] = slot;
+}
+
+static void keystore_index_rebuild(void)
+{
+	int slot;
+
+	memset(key_index, 0xff, sizeof(key_index));
+	for (slot = 0; slot < KEY_MAX_NUMBER; slot++) {
+		if (key_directory[slot].valid)
+			keystore_index_insert(slot);
+	}
+}
+
+static void keystore_directory_set(int slot, uint8_t key_id, uint16_t key_length, const uint8_t *key)
+{
+	bool was_valid = key_directory[slot].valid;
+
+	key_directory[slot].valid = 1;
+	key_directory[slot].key_id = key_id;
+	key_directory[slot].key_length = key_length;
+	key_directory[slot].digest = keystore_key_digest(key);
+
+	if (was_valid)
+		keystore_index_rebuild();
+	else
+		keystore_index_insert(slot);
+}
+
+static void keystore_directory_clear(int slot)
+{
+	memset(&key_directory[slot], 0, sizeof(key_directory[slot]));
+	keystore_index_rebuild();
+}
+
+/**
+ * Build the key directory from the key slots in flash.
+ *
+ * @return Success or the flash read error.
+ */
+static int keystore_directory_load(void)
+{
+	struct Keystore_Package slot_data;
+	struct SpiEngine *spi_flash = getSpiEngineWrapper();
+	int status;
+	int slot;
+
+	memset(key_directory, 0, sizeof(key_directory));
+	memset(key_index, 0xff, sizeof(key_index));
+	key_directory_loaded = false;
+
+	spi_flash->spi.device_id[0] = ROT_INTERNAL_KEY; // Internal UFM SPI
+
+	for (slot = 0; slot < KEY_MAX_NUMBER; slot++) {
+		status = spi_flash->spi.base.read(&spi_flash->spi, slot * KeyStoreKeyMaxLen, &slot_data.keysotre_hdr, KeyStoreHdrLen);
+		if (status != Success) {
+			printk("KeyStore directory load header fail ;Flash read status= %x\n",status);
+			return status;
+		}
+
+		if ((slot_data.keysotre_hdr.key_length == 0xFFFF) && (slot_data.keysotre_hdr.key_id == 0xFF))
+			continue;
+
+		if (slot_data.keysotre_hdr.key_length > KEY_MAX_LENGTH)
+			continue;
+
+		status = spi_flash->spi.base.read(&spi_flash->spi, slot * KeyStoreKeyMaxLen + KeyStoreHdrLen, slot_data.key_buffer, KEY_MAX_LENGTH);
+		if (status != Success) {
+			printk("KeyStore directory load key fail ;Flash read status= %x\n",status);
+			return status;
+		}
+
+		keystore_directory_set(slot, slot_data.keysotre_hdr.key_id, slot_data.keysotre_hdr.key_length, slot_data.key_buffer);
+	}
+
+	key_directory_loaded = true;
+
+	return Success;
+}
+
 int keystore_save_key(struct keystore *store, int id, const uint8_t *key, size_t length)
 {
     int status = 0;    
@@ -57,6 +226,7 @@ int keystore_save_key(struct keystore *store, int id, const uint8_t *key, size_t
 
 	spi_flash->spi.device_id[0] = ROT_INTERNAL_KEY; // Internal UFM SPI
 	
+	keystore_cache_invalidate();
 	status = spi_flash->spi.base.write(&spi_flash->spi, BaseAddr, &StoreBuf, KeyStoreKeyMaxLen);
 	
 	if(status != KeyStoreKeyMaxLen)
@@ -68,6 +238,11 @@ int keystore_save_key(struct keystore *store, int id, const uint8_t *key, size_t
 	{		
         printk("key write success \n");
 		status = Success;
+		// Writing over an occupied slot doesn't give back the new key, resync from flash
+		if (key_directory_loaded && (id < KEY_MAX_NUMBER) && !key_directory[id].valid)
+			keystore_directory_set(id, id, length, &StoreBuf[KeyStoreHdrLen]);
+		else
+			key_directory_loaded = false;
 	}
 
     return status;
@@ -76,33 +251,31 @@ int keystore_save_key(struct keystore *store, int id, const uint8_t *key, size_t
 int keystore_load_key(struct keystore *store, int id, uint8_t **key, size_t *length)
 {
     uint32_t BaseAddr;
-	uint8_t  StoreBuf[KeyStoreHdrLen] ={0};
-	uint16_t StoreBufIndex;
 	uint16_t StoreBufLen;
-	struct Keystore_Header *KeyStorePkgHdr;
 	int status;
 
 	struct SpiEngine *spi_flash = getSpiEngineWrapper();
 
-	spi_flash->spi.device_id[0] = ROT_INTERNAL_KEY; // Internal UFM SPI
-	BaseAddr = id * KeyStoreKeyMaxLen;
+	if ((id < 0) || (id >= KEY_MAX_NUMBER))
+		return KEYSTORE_INVALID_ARGUMENT;
 
-	status = spi_flash->spi.base.read(&spi_flash->spi, BaseAddr, &StoreBuf[0],KeyStoreHdrLen);
-	
-	if (status != Success) {
-		printk("KeyStore_Load_key load header fail ;Flash read status= %x\n",status);
-		return status;	// failed to load key header from SPI
+	if (!key_directory_loaded) {
+		status = keystore_directory_load();
+		if (status != Success)
+			return status;
 	}
 
-	KeyStorePkgHdr = (struct Keystore_Header *)&StoreBuf[0];
-
-	if ((KeyStorePkgHdr->key_length == 0xFF) && (KeyStorePkgHdr->key_id == 0xFF)) {
+	// The header is already in the directory, only the key itself is read from flash
+	if (!key_directory[id].valid) {
 		status = KEYSTORE_NO_KEY;
 		return status;
 	}
 
-	*length = KeyStorePkgHdr->key_length;
-	StoreBufLen = KeyStorePkgHdr->key_length;
+	spi_flash->spi.device_id[0] = ROT_INTERNAL_KEY; // Internal UFM SPI
+	BaseAddr = id * KeyStoreKeyMaxLen;
+
+	*length = key_directory[id].key_length;
+	StoreBufLen = key_directory[id].key_length;
 
 	//store key from flash part
 	status = spi_flash->spi.base.read(&spi_flash->spi, BaseAddr + KeyStoreHdrLen, key,StoreBufLen);
@@ -131,6 +304,7 @@ int keystore_erase_key(struct keystore *store, int id)
 		printk("KeyStore_Erase_key load key section fail ;Flash read status= %x\n",status);
 		return status;	// failed to load key header from SPI
 	}
+	keystore_cache_invalidate();
 	status = spi_flash->spi.base.sector_erase(&spi_flash->spi, BaseAddr);
 
 	if(status)
@@ -152,6 +326,12 @@ int keystore_erase_key(struct keystore *store, int id)
 		status = 0;
 	}
 
+	// Only slots fully inside the rewritten section are wiped, otherwise resync from flash
+	if ((status == 0) && key_directory_loaded && (id >= 0) && ((WipeOutIndex + KeyStoreKeyMaxLen) <= KeySectionSize))
+		keystore_directory_clear(id);
+	else
+		key_directory_loaded = false;
+
     return status;
 }
 
@@ -163,12 +343,16 @@ int keystore_erase_all_keys(struct keystore *store)
 	spi_flash->spi.device_id[0] = ROT_INTERNAL_KEY; // Internal UFM SPI
 	BaseAddr = KeyStoreOffset_0;
 	
+	keystore_cache_invalidate();
 	status = spi_flash->spi.base.sector_erase(&spi_flash->spi, BaseAddr);
 
 	if (status != Success) {
 		printk("KeyStore_Erase_All_Keys key section erase fail ;Flash erase status= %x\n",status);
 	}
 
+	// Only the first section is erased, rebuild the directory from what is left in flash
+	key_directory_loaded = false;
+
 	return status;
 }
 
@@ -186,60 +370,61 @@ int keystoreManager_init (struct Keystore_Manager *key_store)
 	key_store->base.erase_key = keystore_erase_key;
 	key_store->base.erase_all_keys = keystore_erase_all_keys;
 
+	if (!key_directory_loaded)
+		keystore_directory_load();
+
 	return 0;
 }
 
 int keystore_get_key_id(struct keystore *store, uint8_t *key, int *key_id, int *last_key_id)
 {
-    uint32_t BaseAddr;
-	uint8_t  StoreBuf[KeyStoreHdrLen] ={0};
-	uint16_t StoreBufIndex;
-	uint16_t StoreBufLen;
-	struct Keystore_Header *KeyStorePkgHdr;
-	int status;
-	int id = 0;
 	uint8_t key_buffer[KEY_MAX_LENGTH];
-	int key_match = 0;
+	uint32_t digest;
+	uint32_t bucket;
+	int probes;
+	int slot;
+	int status;
 
 	struct SpiEngine *spi_flash = getSpiEngineWrapper();
 
-	spi_flash->spi.device_id[0] = ROT_INTERNAL_KEY; // Internal UFM SPI
-	
-	while (key_match == 0 && id < KEY_MAX_NUMBER) {
-		BaseAddr = id * KeyStoreKeyMaxLen;
+	if (!key_directory_loaded) {
+		status = keystore_directory_load();
+		if (status != Success)
+			return status;
+	}
+
+	digest = keystore_key_digest(key);
+	bucket = digest & (KEY_INDEX_SIZE - 1);
+
+	for (probes = 0; (probes < KEY_INDEX_SIZE) && (key_index[bucket] >= 0); probes++) {
+		slot = key_index[bucket];
+		bucket = (bucket + 1) & (KEY_INDEX_SIZE - 1);
+
+		if (key_directory[slot].digest != digest)
+			continue;
 
-		status = spi_flash->spi.base.read(&spi_flash->spi, BaseAddr, &StoreBuf[0],KeyStoreHdrLen);
-		
+		// Digest hit, confirm against the key in flash
+		spi_flash->spi.device_id[0] = ROT_INTERNAL_KEY; // Internal UFM SPI
+		status = spi_flash->spi.base.read(&spi_flash->spi, slot * KeyStoreKeyMaxLen + KeyStoreHdrLen, key_buffer, KEY_MAX_LENGTH);
 		if (status != Success) {
-			printk("KeyStore_Load_key load header fail ;Flash read status= %x\n",status);
-			return status;	// failed to load key header from SPI
+			printk("KeyStore_Load_key load key fail ;Flash read status= %x\n",status);
+			return KEYSTORE_LOAD_FAILED;
 		}
 
-		KeyStorePkgHdr = (struct Keystore_Header *)&StoreBuf[0];
-		if ((KeyStorePkgHdr->key_length == 0xFFFF) && (KeyStorePkgHdr->key_id == 0xFF)) {
-			status = KEYSTORE_NO_KEY;
-			return status;
+		if (compare_buffer(key, key_buffer, KEY_MAX_LENGTH) == Success) {
+			*key_id = key_directory[slot].key_id;
+			return Success;
 		}
-		
-		StoreBufLen = KeyStorePkgHdr->key_length;
-		//store key from flash part
-		status = spi_flash->spi.base.read(&spi_flash->spi, BaseAddr + KeyStoreHdrLen, &key_buffer, StoreBufLen);
-		if (status != Success) {
-			printk("KeyStore_Load_key load key fail ;Flash read status= %x\n",status);
-			status = KEYSTORE_LOAD_FAILED;
-		} else {
-			// Compare key and key_buffer
-			status = compare_buffer(key, &key_buffer, KEY_MAX_LENGTH);
-			if (status == Success) {
-				key_match = 1;
-				*key_id = KeyStorePkgHdr->key_id;
-			} else {
-				*last_key_id = id;
-			}
+	}
+
+	for (slot = KEY_MAX_NUMBER - 1; slot >= 0; slot--) {
+		if (key_directory[slot].valid) {
+			*last_key_id = slot;
+			break;
 		}
-		id++;
-	}	
-	return status;
+	}
+
+	return KEYSTORE_NO_KEY;
 }
 
 int keystore_save_root_key(struct rsa_public_key *pub_key)
@@ -288,6 +473,7 @@ int keystore_save_root_key(struct rsa_public_key *pub_key)
 
 	spi_flash->spi.device_id[0] = ROT_INTERNAL_INTEL_STATE; // Root Key save to Intel State
 	
+	keystore_cache_invalidate();
 	status = spi_flash->spi.base.write(&spi_flash->spi, BaseAddr, StoreBuf, rootkey_contain_size);
 	
 	if(status != rootkey_contain_size)
@@ -23,6 +23,8 @@
 #define KEY_MAX_LENGTH  256
 #define KEY_MAX_NUMBER 128
 #define KeyStoreOffset_200			0x200
+#define KEY_CACHE_ENTRIES			4		// parsed public keys kept in RAM
+#define KEY_INDEX_SIZE				256		// key directory hash buckets, power of two > KEY_MAX_NUMBER
 
 struct Keystore_Manager {
     struct keystore base;
@@ -40,10 +42,29 @@ struct Keystore_Package
 	uint8_t key_buffer[KEY_MAX_LENGTH];
 };
 
+struct Keystore_Directory_Entry
+{
+	uint32_t digest;
+	uint16_t key_length;
+	uint8_t key_id;
+	uint8_t valid;
+};
+
+struct Keystore_Cache_Entry
+{
+	uint8_t valid;
+	uint8_t flash_id;
+	uint32_t address;
+	struct rsa_public_key pub_key;
+};
+
 
 
 int keystoreManager_init (struct Keystore_Manager *key_store);
 int keystore_get_key_id(struct keystore *store, uint8_t *key, int *key_id, int *last_key_id);
 int keystore_get_root_key(struct rsa_public_key *pub_key);
 int keystore_save_root_key(struct rsa_public_key *pub_key);
+int keystore_cache_get_public_key(uint8_t flash_id, uint32_t address, struct rsa_public_key *pub_key);
+void keystore_cache_put_public_key(uint8_t flash_id, uint32_t address, const struct rsa_public_key *pub_key);
+void keystore_cache_invalidate(void);
 #endif
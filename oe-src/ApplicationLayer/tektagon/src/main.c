@@ -15,6 +15,8 @@
 #include "pfr/pfr_common.h"
 #include <CommonLogging/CommonLogging.h>
 #include <I2c/I2c.h>
+#include "boot_profile/boot_profile.h"
+#include <gpio/gpio_aspeed.h>
 
 #ifdef CONFIG_INTEL_PFR_SUPPORT
 #include "intel_2.0/intel_pfr_verification.h"
@@ -41,19 +43,32 @@ void main(void)
 {
 	int status = 0;
 	
+	boot_profile_start();
 	printk("\r\n *** Tektagon OE version 1.1.00 ***\r\n");
 	// DEBUG_HALT();
+	boot_profile_phase_begin(BOOT_PHASE_ENGINE_INIT);
 	status = initializeEngines();
+	boot_profile_phase_end(BOOT_PHASE_ENGINE_INIT);
+	boot_profile_phase_begin(BOOT_PHASE_MANIFEST_INIT);
 	status = initializeManifestProcessor();
+	boot_profile_phase_end(BOOT_PHASE_MANIFEST_INIT);
+	boot_profile_phase_begin(BOOT_PHASE_DEBUG_INIT);
 	DebugInit();//State Machine log saving
+	boot_profile_phase_end(BOOT_PHASE_DEBUG_INIT);
 
+	boot_profile_phase_begin(BOOT_PHASE_BOOT_HOLD);
 	BMCBootHold();
 	PCHBootHold();
+	boot_profile_phase_end(BOOT_PHASE_BOOT_HOLD);
 
 	#if SMBUS_MAILBOX_SUPPORT
+	boot_profile_phase_begin(BOOT_PHASE_MAILBOX_INIT);
     	InitializeSmbusMailbox();
     	SetPlatformState(ENTER_T_MINUS_1);
+	boot_profile_phase_end(BOOT_PHASE_MAILBOX_INIT);
 	#endif
 
+	// Mailbox init overlaps the reset settle time, the state machine starts on host flash
+	BootHoldReleaseWait();
 	StartHrotStateMachine();
 }
@@ -9,6 +9,8 @@
 #include "CommonFlash/CommonFlash.h"
 #include "state_machine/common_smc.h"
 #include "Definition.h"
+#include "keystore/KeystoreManager.h"
+#include "Smbus_mailbox/Smbus_mailbox.h"
 #ifdef CONFIG_INTEL_PFR_SUPPORT
 #include "intel_2.0/intel_pfr_definitions.h"
 #endif
@@ -62,8 +64,11 @@ int ufm_write(uint32_t ufm_id, uint32_t offset, uint8_t *data, uint32_t data_len
 }
 
 int ufm_erase(uint32_t ufm_id){
-    if(ufm_id == PROVISION_UFM)
+    if(ufm_id == PROVISION_UFM) {
+        provision_shadow_invalidate();
+        keystore_cache_invalidate();
         return pfr_spi_erase_4k(ROT_INTERNAL_INTEL_STATE, 0);
+    }
     else if(ufm_id == UPDATE_STATUS_UFM)
         return pfr_spi_erase_4k(ROT_INTERNAL_STATE, 0);
     else
@@ -11,6 +11,7 @@
 #include "state_machine/common_smc.h"
 #include "include/SmbusMailBoxCom.h"
 #include <drivers/misc/aspeed/pfr_aspeed.h>
+#include <gpio/gpio_aspeed.h>
 #include <StateMachineAction/StateMachineActions.h>
 #include "pfr_common.h"
 #ifdef CONFIG_INTEL_PFR_SUPPORT
@@ -40,6 +41,8 @@ int handle_update_image_action(int image_type, void* EventContext)
 
 	BMCBootHold();
 	PCHBootHold();
+	// Both hosts must be in reset before their images are rewritten
+	BootHoldReleaseWait();
 	 
 
 #if SMBUS_MAILBOX_SUPPORT
@@ -17,10 +17,18 @@
 #include "flash/flash_util.h"
 #include "state_machine/common_smc.h"
 #include "pfr_common.h"
+#include "Common.h"
+#include "abr/abr_aspeed.h"
+#include "crypto/ecdsa_aspeed.h"
+#include <Crypto/HashWrapper.h>
+#include <Flash/FlashWrapper.h>
+#include <zephyr.h>
 #include <sys/reboot.h>
 #include <crypto/ecdsa_structs.h>
 #include <crypto/ecdsa.h>
 #include "mbedtls/ecdsa.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/sha512.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -44,7 +52,7 @@ int pfr_spi_read(unsigned int device_id, unsigned int address, unsigned int data
 	int status = 0;
 	struct SpiEngine *spi_flash = getSpiEngineWrapper();
 	spi_flash->spi.device_id[0] = device_id; // assign the flash device id,  0:spi1_cs0, 1:spi2_cs0 , 2:spi2_cs1, 3:spi2_cs2, 4:fmc_cs0, 5:fmc_cs1
-	spi_flash->spi.base.read(&spi_flash->spi,address,data,data_length);
+	Wrapper_spi_flash_read(&spi_flash->spi,address,data,data_length);
 	return Success;
 }
 
@@ -53,7 +61,7 @@ int pfr_spi_write(unsigned int device_id, unsigned int address, unsigned int dat
 	int status = 0;
 	struct SpiEngine *spi_flash = getSpiEngineWrapper();
 	spi_flash->spi.device_id[0] = device_id; // assign the flash device id,  0:spi1_cs0, 1:spi2_cs0 , 2:spi2_cs1, 3:spi2_cs2, 4:fmc_cs0, 5:fmc_cs1
-	spi_flash->spi.base.write(&spi_flash->spi,address,data,data_length);
+	Wrapper_spi_flash_write(&spi_flash->spi,address,data,data_length);
 	return Success;
 }
 
@@ -61,7 +69,7 @@ int pfr_spi_erase_4k(unsigned int device_id, unsigned int address){
 	int status = 0;
 	struct SpiEngine *spi_flash = getSpiEngineWrapper();
 	spi_flash->spi.device_id[0] = device_id; // assign the flash device id,  0:spi1_cs0, 1:spi2_cs0 , 2:spi2_cs1, 3:spi2_cs2, 4:fmc_cs0, 5:fmc_cs1
-	spi_flash->spi.base.sector_erase(&spi_flash->spi,address);
+	Wrapper_spi_flash_sector_erase(&spi_flash->spi,address);
 	return Success;
 }
 
@@ -75,9 +83,9 @@ int pfr_spi_page_read_write(unsigned int device_id, uint32_t *source_address,uin
 	spi_flash->spi.device_id[0] = device_id; // assign the flash device id,  0:spi1_cs0, 1:spi2_cs0 , 2:spi2_cs1, 3:spi2_cs2, 4:fmc_cs0, 5:fmc_cs1
 
 	for (index1 = 0; index1 < (PAGE_SIZE / MAX_READ_SIZE); index1 ++){
-		spi_flash->spi.base.read(&spi_flash->spi,*source_address, buffer, MAX_READ_SIZE);
+		Wrapper_spi_flash_read(&spi_flash->spi,*source_address, buffer, MAX_READ_SIZE);
 		for (index2 = 0; index2 < (MAX_READ_SIZE / MAX_WRITE_SIZE);index2 ++){
-			spi_flash->spi.base.write(&spi_flash->spi,*target_address,&buffer[index2 * MAX_WRITE_SIZE], MAX_WRITE_SIZE);
+			Wrapper_spi_flash_write(&spi_flash->spi,*target_address,&buffer[index2 * MAX_WRITE_SIZE], MAX_WRITE_SIZE);
 			*target_address += MAX_WRITE_SIZE;
 		}
 
@@ -98,11 +106,11 @@ int pfr_spi_page_read_write_between_spi(int source_flash, uint32_t *source_addre
 
 	for (index1 = 0; index1 < (PAGE_SIZE / MAX_READ_SIZE); index1 ++){
 		spi_flash->spi.device_id[0] = source_flash; // assign the flash device id,  0:spi1_cs0, 1:spi2_cs0 , 2:spi2_cs1, 3:spi2_cs2, 4:fmc_cs0, 5:fmc_cs1
-		spi_flash->spi.base.read(&spi_flash->spi,*source_address, buffer, MAX_READ_SIZE);
+		Wrapper_spi_flash_read(&spi_flash->spi,*source_address, buffer, MAX_READ_SIZE);
 	
 		for (index2 = 0; index2 < (MAX_READ_SIZE / MAX_WRITE_SIZE);index2 ++){
 			spi_flash->spi.device_id[0] = target_flash; 
-			spi_flash->spi.base.write(&spi_flash->spi,*target_address,&buffer[index2 * MAX_WRITE_SIZE], MAX_WRITE_SIZE);
+			Wrapper_spi_flash_write(&spi_flash->spi,*target_address,&buffer[index2 * MAX_WRITE_SIZE], MAX_WRITE_SIZE);
 	
 			*target_address += MAX_WRITE_SIZE;
 		}
@@ -113,6 +121,222 @@ int pfr_spi_page_read_write_between_spi(int source_flash, uint32_t *source_addre
 	return Success;
 }
 
+#define COPY_PIPELINE_DEPTH		2
+#define COPY_BLOCK_SIZE			0x10000
+#define COPY_WRITER_STACK_SIZE		4096		// Flash command frames hold no data buffers, only the driver call chain
+
+/*
+ * One above the main thread, which runs the reader.  The writer takes each chunk as soon as it is
+ * queued and only gives the CPU back while it waits on the target flash, so the target never sits
+ * idle while the reader has data for it.
+ */
+#define COPY_WRITER_PRIORITY		(CONFIG_MAIN_THREAD_PRIORITY - 1)
+
+/*
+ * Chunk handed from the reader to the writer thread.  A NULL data pointer with a non-zero length
+ * asks the writer to pre-erase the destination, a NULL data pointer with a zero length ends the
+ * copy.
+ */
+struct copy_chunk {
+	uint8_t *data;
+	uint32_t address;
+	uint32_t length;
+};
+
+static uint8_t copy_buffer[COPY_PIPELINE_DEPTH][MAX_READ_SIZE];
+static struct spi_flash copy_target_flash;
+static atomic_t copy_writer_status;
+
+K_MSGQ_DEFINE(copy_chunk_queue, sizeof(struct copy_chunk), COPY_PIPELINE_DEPTH + 1, 4);
+K_SEM_DEFINE(copy_buffer_free, COPY_PIPELINE_DEPTH, COPY_PIPELINE_DEPTH);
+K_SEM_DEFINE(copy_writer_done, 0, 1);
+
+/**
+    Function to erase exactly the destination of a copy, using 64K block erases where the device
+    supports them and a whole block lies inside the range, 4K sector erases elsewhere
+
+    @Param  flash       Target flash, with device_id set
+    @Param  address     Start offset, 4K aligned
+    @Param  length      Number of bytes, a multiple of 4K
+
+    @retval int         Success or Failure
+**/
+static int copy_erase_region(struct spi_flash *flash, uint32_t address, uint32_t length)
+{
+	uint32_t end = address + length;
+	bool block_erase = (flash->device_id[0] == BMC_SPI || flash->device_id[0] == PCH_SPI);
+	int status = 0;
+
+	if ((address % PAGE_SIZE) || (length % PAGE_SIZE))
+		return Failure;
+
+	while (address < end) {
+		if (block_erase && !(address % COPY_BLOCK_SIZE) && (end - address) >= COPY_BLOCK_SIZE) {
+			status = Wrapper_spi_flash_block_erase(flash, address);
+			address += COPY_BLOCK_SIZE;
+		} else {
+			status = Wrapper_spi_flash_sector_erase(flash, address);
+			address += PAGE_SIZE;
+		}
+		if (status != Success)
+			return Failure;
+	}
+
+	return Success;
+}
+
+/*
+ * Writer side of the copy pipeline.  It owns its own spi_flash instance so that the device_id of
+ * the shared SPI engine can keep pointing at the source while the reader fetches the next chunk.
+ */
+static void copy_writer_thread(void *arg1, void *arg2, void *arg3)
+{
+	struct copy_chunk chunk;
+	int status = 0;
+
+	while (1) {
+		k_msgq_get(&copy_chunk_queue, &chunk, K_FOREVER);
+
+		if (chunk.data == NULL) {
+			if (chunk.length == 0) {
+				k_sem_give(&copy_writer_done);
+				continue;
+			}
+
+			if (copy_erase_region(&copy_target_flash, chunk.address, chunk.length) != Success)
+				atomic_set(&copy_writer_status, Failure);
+			continue;
+		}
+
+		// Keep draining after a failure so the reader never blocks on a buffer
+		if (atomic_get(&copy_writer_status) == Success) {
+			status = Wrapper_spi_flash_write(&copy_target_flash, chunk.address, chunk.data, chunk.length);
+			if (status != chunk.length)
+				atomic_set(&copy_writer_status, Failure);
+		}
+
+		k_sem_give(&copy_buffer_free);
+	}
+}
+
+K_THREAD_DEFINE(copy_writer, COPY_WRITER_STACK_SIZE, copy_writer_thread, NULL, NULL, NULL,
+		COPY_WRITER_PRIORITY, 0, 0);
+
+/**
+    Function to copy a flash area and verify it by digest instead of a buffer compare.
+    Reads of the source are double buffered against the erase and program of the destination,
+    which runs in the copy writer thread, and the source is hashed while it is read.  The
+    destination is then hashed once and the two SHA256 digests are compared.
+
+    @Param  source_flash    Source flash device id
+    @Param  source_address  Source offset
+    @Param  target_flash    Target flash device id
+    @Param  target_address  Target offset, erased before the copy, 4K aligned
+    @Param  length          Number of bytes to copy, a multiple of 4K
+
+    @retval int             Success or Failure
+**/
+int pfr_spi_copy_and_verify(int source_flash, uint32_t source_address, int target_flash,
+	uint32_t target_address, uint32_t length)
+{
+	struct SpiEngine *spi_flash = getSpiEngineWrapper();
+	uint8_t source_digest[SHA256_HASH_LENGTH];
+	uint8_t target_digest[SHA256_HASH_LENGTH];
+	struct copy_chunk chunk = {0};
+	uint32_t offset;
+	uint32_t size;
+	int index = 0;
+	int status = 0;
+
+	// Only whole sectors are erased, a partial one would lose the data around the copy
+	if ((target_address % PAGE_SIZE) || (length % PAGE_SIZE))
+		return Failure;
+
+	copy_target_flash = spi_flash->spi;
+	copy_target_flash.device_id[0] = target_flash;
+	atomic_set(&copy_writer_status, Success);
+
+	status = HashEngineStartSha256();
+	if (status != Success)
+		return Failure;
+
+	// The destination is erased while the first buffers are filled
+	chunk.address = target_address;
+	chunk.length = length;
+	k_msgq_put(&copy_chunk_queue, &chunk, K_FOREVER);
+
+	for (offset = 0; offset < length; offset += size) {
+		size = ((length - offset) < MAX_READ_SIZE) ? (length - offset) : MAX_READ_SIZE;
+
+		k_sem_take(&copy_buffer_free, K_FOREVER);
+		if (atomic_get(&copy_writer_status) != Success) {
+			k_sem_give(&copy_buffer_free);
+			break;
+		}
+
+		chunk.data = copy_buffer[index];
+		chunk.address = target_address + offset;
+		chunk.length = size;
+		index = (index + 1) % COPY_PIPELINE_DEPTH;
+
+		spi_flash->spi.device_id[0] = source_flash;
+		status = Wrapper_spi_flash_read(&spi_flash->spi, source_address + offset, chunk.data, size);
+		if (status == Success)
+			status = HashEngineUpdate(chunk.data, size);
+		if (status != Success) {
+			k_sem_give(&copy_buffer_free);
+			break;
+		}
+
+		k_msgq_put(&copy_chunk_queue, &chunk, K_FOREVER);
+	}
+
+	chunk.data = NULL;
+	chunk.length = 0;
+	k_msgq_put(&copy_chunk_queue, &chunk, K_FOREVER);
+	k_sem_take(&copy_writer_done, K_FOREVER);
+
+	if (offset < length || atomic_get(&copy_writer_status) != Success)
+		goto cancel;
+
+	status = HashEngineFinish(source_digest, sizeof(source_digest));
+	if (status != Success)
+		goto cancel;
+
+	// Single read-back pass of the destination
+	status = HashEngineStartSha256();
+	if (status != Success)
+		return Failure;
+
+	spi_flash->spi.device_id[0] = target_flash;
+	for (offset = 0; offset < length; offset += size) {
+		size = ((length - offset) < MAX_READ_SIZE) ? (length - offset) : MAX_READ_SIZE;
+
+		status = Wrapper_spi_flash_read(&spi_flash->spi, target_address + offset, copy_buffer[0], size);
+		if (status != Success)
+			goto cancel;
+
+		status = HashEngineUpdate(copy_buffer[0], size);
+		if (status != Success)
+			goto cancel;
+	}
+
+	status = HashEngineFinish(target_digest, sizeof(target_digest));
+	if (status != Success)
+		goto cancel;
+
+	if (compare_buffer(source_digest, target_digest, sizeof(source_digest)) != Success) {
+		DEBUG_PRINTF("Copy verification failed\r\n");
+		return Failure;
+	}
+
+	return Success;
+
+cancel:
+	HashEngineCancel();
+	return Failure;
+}
+
 // calculates sha for dataBuffer
 int get_buffer_hash(struct pfr_manifest *manifest, uint8_t *data_buffer, uint8_t length, unsigned char *hash_out) {
 
@@ -136,9 +360,238 @@ int esb_ecdsa_verify(struct pfr_manifest *manifest, unsigned int digest[], unsig
 	return Success;
 }
 
+#define HASH_BATCH_PAGES	4
+
+/*
+ * Flash pages are read back to back into one buffer and handed to the hash engine as a single
+ * update per batch.  The Zephyr hash API only takes contiguous input and the HACE driver builds
+ * its descriptor table internally, so this is the largest job a caller can submit.
+ */
+static uint8_t hash_batch_buffer[HASH_BATCH_PAGES * MAX_READ_SIZE];
+
+/**
+ * Calculate one digest over a list of flash regions.  Up to HASH_BATCH_PAGES pages are read per
+ * round and hashed as one engine job.
+ *
+ * @param device_id Flash device holding the regions.
+ * @param regions Regions to hash, in order.
+ * @param count Number of regions.
+ * @param hash_type HASH_TYPE_SHA256 or HASH_TYPE_SHA384.
+ * @param hash_out Output buffer for the digest.
+ * @param hash_length Length of the output buffer.
+ *
+ * @return Success or Failure.
+ */
+int pfr_spi_hash_regions(unsigned int device_id, const struct pfr_hash_region *regions, size_t count,
+	uint32_t hash_type, uint8_t *hash_out, size_t hash_length)
+{
+	size_t region = 0;
+	uint32_t offset = 0;
+	uint32_t fill;
+	uint32_t size;
+	int status = 0;
+
+	if (hash_type == HASH_TYPE_SHA256)
+		status = HashEngineStartSha256();
+	else if (hash_type == HASH_TYPE_SHA384)
+		status = HashEngineStartSha384();
+	else
+		return Failure;
+
+	if (status)
+		return Failure;
+
+	while (region < count) {
+		for (fill = 0; fill < sizeof(hash_batch_buffer) && region < count;) {
+			if (offset >= regions[region].length) {
+				region++;
+				offset = 0;
+				continue;
+			}
+
+			size = regions[region].length - offset;
+			if (size > MAX_READ_SIZE)
+				size = MAX_READ_SIZE;
+			if (size > sizeof(hash_batch_buffer) - fill)
+				size = sizeof(hash_batch_buffer) - fill;
+
+			status = pfr_spi_read(device_id, regions[region].start_address + offset, size, &hash_batch_buffer[fill]);
+			if (status != Success)
+				goto cancel;
+
+			fill += size;
+			offset += size;
+		}
+
+		if (fill && HashEngineUpdate(hash_batch_buffer, fill))
+			goto cancel;
+	}
+
+	if (HashEngineFinish(hash_out, hash_length))
+		return Failure;
+
+	return Success;
+
+cancel:
+	HashEngineCancel();
+	return Failure;
+}
+
+/**
+ * Software hash context for the inner range of pfr_spi_hash_nested().  The hash engine only runs
+ * one session at a time, so the inner digest is calculated by the CPU on the pages already read
+ * for the outer one.
+ */
+struct pfr_nested_hash {
+	uint32_t hash_type;
+	union {
+		mbedtls_sha256_context sha256;
+#if defined(MBEDTLS_SHA512_C)
+		mbedtls_sha512_context sha512;
+#endif
+	} ctx;
+};
+
+static int pfr_nested_hash_start(struct pfr_nested_hash *nested, uint32_t hash_type)
+{
+	nested->hash_type = hash_type;
+
+	if (hash_type == HASH_TYPE_SHA256) {
+		mbedtls_sha256_init(&nested->ctx.sha256);
+		return mbedtls_sha256_starts_ret(&nested->ctx.sha256, 0) ? Failure : Success;
+	}
+#if defined(MBEDTLS_SHA512_C)
+	if (hash_type == HASH_TYPE_SHA384) {
+		mbedtls_sha512_init(&nested->ctx.sha512);
+		return mbedtls_sha512_starts_ret(&nested->ctx.sha512, 1) ? Failure : Success;
+	}
+#endif
+
+	return Failure;
+}
+
+static int pfr_nested_hash_update(struct pfr_nested_hash *nested, const uint8_t *data, size_t length)
+{
+#if defined(MBEDTLS_SHA512_C)
+	if (nested->hash_type == HASH_TYPE_SHA384)
+		return mbedtls_sha512_update_ret(&nested->ctx.sha512, data, length) ? Failure : Success;
+#endif
+
+	return mbedtls_sha256_update_ret(&nested->ctx.sha256, data, length) ? Failure : Success;
+}
+
+static int pfr_nested_hash_finish(struct pfr_nested_hash *nested, uint8_t *hash_out)
+{
+	int status;
+
+#if defined(MBEDTLS_SHA512_C)
+	if (nested->hash_type == HASH_TYPE_SHA384) {
+		status = mbedtls_sha512_finish_ret(&nested->ctx.sha512, hash_out);
+		mbedtls_sha512_free(&nested->ctx.sha512);
+		return status ? Failure : Success;
+	}
+#endif
+
+	status = mbedtls_sha256_finish_ret(&nested->ctx.sha256, hash_out);
+	mbedtls_sha256_free(&nested->ctx.sha256);
+	return status ? Failure : Success;
+}
+
+static void pfr_nested_hash_free(struct pfr_nested_hash *nested)
+{
+#if defined(MBEDTLS_SHA512_C)
+	if (nested->hash_type == HASH_TYPE_SHA384) {
+		mbedtls_sha512_free(&nested->ctx.sha512);
+		return;
+	}
+#endif
+
+	mbedtls_sha256_free(&nested->ctx.sha256);
+}
+
+/**
+ * Calculate the digest of a flash region together with the digest of a range nested inside it,
+ * reading the flash only once.  This is used for capsules, whose protected content carries a
+ * signed PFM that is authenticated on its own right after the capsule.
+ *
+ * @param device_id Flash device holding the regions.
+ * @param outer Region to hash with the hash engine.
+ * @param inner Range to hash as well, fully contained in the outer region.
+ * @param hash_type HASH_TYPE_SHA256 or HASH_TYPE_SHA384, used for both digests.
+ * @param outer_out Output buffer for the digest of the outer region.
+ * @param inner_out Output buffer for the digest of the inner range.
+ * @param hash_length Length of each output buffer.
+ *
+ * @return Success or Failure.  Failure is also returned when the hash type can't be calculated in
+ * software, so the caller can fall back to hashing each region separately.
+ */
+int pfr_spi_hash_nested(unsigned int device_id, const struct pfr_hash_region *outer,
+	const struct pfr_hash_region *inner, uint32_t hash_type, uint8_t *outer_out, uint8_t *inner_out,
+	size_t hash_length)
+{
+	struct pfr_nested_hash nested;
+	uint32_t inner_end = inner->start_address + inner->length;
+	uint32_t offset = 0;
+	uint32_t address;
+	uint32_t first;
+	uint32_t last;
+	uint32_t fill;
+	uint32_t size;
+	int status = 0;
+
+	if (inner->start_address < outer->start_address ||
+	    inner_end > (outer->start_address + outer->length) || inner_end < inner->start_address)
+		return Failure;
+
+	if (pfr_nested_hash_start(&nested, hash_type) != Success)
+		return Failure;
+
+	if (hash_type == HASH_TYPE_SHA256)
+		status = HashEngineStartSha256();
+	else
+		status = HashEngineStartSha384();
+
+	if (status) {
+		pfr_nested_hash_free(&nested);
+		return Failure;
+	}
+
+	while (offset < outer->length) {
+		for (fill = 0; fill < sizeof(hash_batch_buffer) && offset < outer->length; fill += size, offset += size) {
+			address = outer->start_address + offset;
+			size = ((outer->length - offset) < MAX_READ_SIZE) ? (outer->length - offset) : MAX_READ_SIZE;
+			status = pfr_spi_read(device_id, address, size, &hash_batch_buffer[fill]);
+			if (status != Success)
+				goto cancel;
+
+			// Feed the part of the page that falls inside the inner range
+			first = (address > inner->start_address) ? address : inner->start_address;
+			last = ((address + size) < inner_end) ? (address + size) : inner_end;
+			if (first < last &&
+			    pfr_nested_hash_update(&nested, &hash_batch_buffer[fill + (first - address)], last - first) != Success)
+				goto cancel;
+		}
+
+		if (HashEngineUpdate(hash_batch_buffer, fill))
+			goto cancel;
+	}
+
+	if (HashEngineFinish(outer_out, hash_length)) {
+		pfr_nested_hash_free(&nested);
+		return Failure;
+	}
+
+	return pfr_nested_hash_finish(&nested, inner_out);
+
+cancel:
+	HashEngineCancel();
+	pfr_nested_hash_free(&nested);
+	return Failure;
+}
+
 // Calculate hash digest
 int get_hash(struct manifest *manifest, struct hash_engine *hash_engine, uint8_t *hash_out, size_t hash_length){
-	int status = 0;
+	struct pfr_hash_region region;
 
 	struct pfr_manifest *pfr_manifest = (struct pfr_manifest *)manifest;
 	
@@ -146,9 +599,12 @@ int get_hash(struct manifest *manifest, struct hash_engine *hash_engine, uint8_t
 		hash_out == NULL || hash_length < SHA256_HASH_LENGTH ||
 		(hash_length > SHA256_HASH_LENGTH && hash_length < SHA384_HASH_LENGTH))
 		return Failure;
-	flash_hash_contents(pfr_manifest->flash, pfr_manifest->pfr_hash->start_address, pfr_manifest->pfr_hash->length, pfr_manifest->hash, pfr_manifest->pfr_hash->type, hash_out, hash_length);
-	
-	return Success;
+
+	region.start_address = pfr_manifest->pfr_hash->start_address;
+	region.length = pfr_manifest->pfr_hash->length;
+
+	return pfr_spi_hash_regions(pfr_manifest->flash->device_id[0], &region, 1, pfr_manifest->pfr_hash->type,
+		hash_out, hash_length);
 }
 
 //print buffer
@@ -189,10 +645,18 @@ static int mbedtls_ecdsa_verify_middlelayer(struct pfr_pubkey *pubkey,
 {
 	mbedtls_ecdsa_context ctx_verify;
 	mbedtls_mpi r, s;
-	unsigned char hash[SHA256_HASH_LENGTH];
+	unsigned char hash[SHA384_HASH_LENGTH];
+	mbedtls_ecp_group_id group_id;
 	int ret = 0;
 	char z = 1;
 
+	if (pubkey->length == SHA256_HASH_LENGTH)
+		group_id = MBEDTLS_ECP_DP_SECP256R1;
+	else if (pubkey->length == SHA384_HASH_LENGTH)
+		group_id = MBEDTLS_ECP_DP_SECP384R1;
+	else
+		return Failure;
+
 	mbedtls_ecdsa_init(&ctx_verify);
 	mbedtls_mpi_init(&r);
 	mbedtls_mpi_init(&s);
@@ -213,9 +677,9 @@ static int mbedtls_ecdsa_verify_middlelayer(struct pfr_pubkey *pubkey,
 
 	mbedtls_mpi_read_binary(&s, signature_s, pubkey->length /*SHA256_HASH_LENGTH*/);
 
-	mbedtls_ecp_group_load(&ctx_verify.MBEDTLS_PRIVATE(grp), MBEDTLS_ECP_DP_SECP256R1);
+	mbedtls_ecp_group_load(&ctx_verify.MBEDTLS_PRIVATE(grp), group_id);
 	memcpy(hash, digest, pubkey->length /*SHA256_HASH_LENGTH*/);
-	ret = mbedtls_ecdsa_verify(&ctx_verify.MBEDTLS_PRIVATE(grp), hash, SHA256_HASH_LENGTH,
+	ret = mbedtls_ecdsa_verify(&ctx_verify.MBEDTLS_PRIVATE(grp), hash, pubkey->length,
 							   &ctx_verify.MBEDTLS_PRIVATE(Q), &r, &s);
 
 	mbedtls_ecdsa_free(&ctx_verify);
@@ -244,15 +708,22 @@ int verify_signature(struct signature_verification *verification, const uint8_t
 	int status = Success;
 
 	struct pfr_manifest *manifest = (struct pfr_manifest *)verification;
+	struct pfr_pubkey *pubkey = manifest->verification->pubkey;
 	// uint8_t signature_r[SHA256_HASH_LENGTH];
 	// uint8_t signature_s[SHA256_HASH_LENGTH];
 	// memcpy(&signature_r[0],&signature[0],length);
 	// memcpy(&signature_s[0],&signature[length],length);
 
-	status =  mbedtls_ecdsa_verify_middlelayer(manifest->verification->pubkey,
+	// P-256 and P-384 go to the ECDSA engine, software only when it cannot take the request
+	status = aspeed_ecdsa_verify_middlelayer(pubkey->x, pubkey->y, pubkey->length,
+						 digest, length, pubkey->signature_r, pubkey->signature_s);
+	if (status != ASPEED_ECDSA_UNAVAILABLE)
+		return status;
+
+	status =  mbedtls_ecdsa_verify_middlelayer(pubkey,
 														digest,
-														manifest->verification->pubkey->signature_r,
-														manifest->verification->pubkey->signature_s);
+														pubkey->signature_r,
+														pubkey->signature_s);
 
 	return status;
 }
@@ -266,6 +737,9 @@ int pfr_cpld_update_reboot (void)
 	k_sleep(K_MSEC(CONFIG_KERNEL_SHELL_REBOOT_DELAY));
 #endif
 
+	if (abr_switch_requested())
+		abr_switch_boot_source();
+
 	sys_reboot(SYS_REBOOT_COLD);
 
 	CODE_UNREACHABLE;
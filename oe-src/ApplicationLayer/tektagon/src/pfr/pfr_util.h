@@ -10,6 +10,7 @@
 #define PFR_UTIL_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 int pfr_spi_read(unsigned int device_id,unsigned int address,
 						unsigned int data_length, unsigned char *data);
@@ -21,11 +22,26 @@ int pfr_spi_page_read_write(unsigned int device_id, uint32_t *source_address,uin
 
 int pfr_spi_erase_4k(unsigned int device_id,unsigned int address);
 
+int pfr_spi_copy_and_verify(int source_flash, uint32_t source_address, int target_flash,
+	uint32_t target_address, uint32_t length);
+
 int esb_ecdsa_verify(struct pfr_manifest *manifest, unsigned int digest[], unsigned char pub_key[], 
 							unsigned char signature[], unsigned char *auth_pass);
 
 int get_buffer_hash(struct pfr_manifest *manifest,uint8_t *data_buffer, uint8_t length, unsigned char *hash_out);
 
+struct pfr_hash_region {
+	uint32_t start_address;
+	uint32_t length;
+};
+
+int pfr_spi_hash_regions(unsigned int device_id, const struct pfr_hash_region *regions, size_t count,
+	uint32_t hash_type, uint8_t *hash_out, size_t hash_length);
+
+int pfr_spi_hash_nested(unsigned int device_id, const struct pfr_hash_region *outer,
+	const struct pfr_hash_region *inner, uint32_t hash_type, uint8_t *outer_out, uint8_t *inner_out,
+	size_t hash_length);
+
 int get_hash(struct manifest *manifest, struct hash_engine *hash_engine, uint8_t *hash_out,
 	size_t hash_length);
 
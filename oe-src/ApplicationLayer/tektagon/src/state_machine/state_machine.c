@@ -14,6 +14,7 @@
 #include "include/SmbusMailBoxCom.h"
 #include "Smbus_mailbox/Smbus_mailbox.h"
 #include "logging/debug_log.h"// State Machine log saving
+#include "boot_profile/boot_profile.h"
 
 K_FIFO_DEFINE(evt_q);
 
@@ -127,6 +128,7 @@ static void i2c_exit(void *context)
 /* verify State Handlers */
 static void verify_entry(void *context)
 {
+	boot_profile_phase_begin(BOOT_PHASE_VERIFY);
 	debug_log_create_entry(DEBUG_LOG_SEVERITY_INFO, DEBUG_LOG_COMPONENT_VERIFY, VERIFY_LOG_COMPONENT_ENTRY_START, 0, 0);
 	debug_log_flush();// State Machine log saving to SPI
 
@@ -157,6 +159,7 @@ static void verify_exit(void *context)
 	struct hrot_smc_context *sm_context = (struct hrot_smc_context *)context;
 	void *sm_static_data = sm_context->sm_static_data;
 	handleVerifyExitState(sm_static_data);
+	boot_profile_phase_end(BOOT_PHASE_VERIFY);
 }
 
 /* recovery State Handlers */
@@ -165,6 +168,7 @@ static void recovery_entry(void *context)
 	struct hrot_smc_context *sm_context = (struct hrot_smc_context *)context;
 	void *sm_static_data = sm_context->sm_static_data;
 
+	boot_profile_phase_begin(BOOT_PHASE_RECOVERY);
 	debug_log_create_entry(DEBUG_LOG_SEVERITY_INFO, DEBUG_LOG_COMPONENT_RECOVERY, RECOVERY_LOG_COMPONENT_ENTRY_START, 0, 0);
 	debug_log_flush();// State Machine log saving to SPI
 
@@ -213,6 +217,7 @@ static void recovery_exit(void *context)
 
 	// printk("Executing recovery_exit\r\n");
 	handleRecoveryExitState(sm_static_data);
+	boot_profile_phase_end(BOOT_PHASE_RECOVERY);
 	// printk("Leaving recovery_exit\r\n");
 }
 
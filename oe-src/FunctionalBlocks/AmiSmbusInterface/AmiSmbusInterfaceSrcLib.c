@@ -19,11 +19,45 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include "AmiSmbusInterfaceSrcLib.h"
 //#include <openbmc/obmc-i2c.h>
 //#include <openbmc/kv.h>
 
+static int datalayer_receive(unsigned char slot_id, int fd, unsigned char *DataLayerAckBuffer,
+                             unsigned int timeout_ms, int verbose);
+
+/**
+  Monotonic time stamp in microseconds
+  
+  @retval unsigned long long
+  
+**/
+static unsigned long long
+smbus_time_us(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((unsigned long long)now.tv_sec * 1000000ULL) + (now.tv_nsec / 1000);
+}
+
+/**
+  Sleep for the current backoff interval and double it for the next failure
+
+  @param  IN OUT unsigned int *delay_us - Current interval, updated to the next one
+  @param  IN unsigned int max_us - Upper bound of the interval
+  
+  @retval void
+
+**/
+static void
+smbus_backoff(unsigned int *delay_us, unsigned int max_us, int verbose)
+{
+  MicroSecondDelay(*delay_us, verbose);
+  *delay_us = ((*delay_us * 2) < max_us) ? (*delay_us * 2) : max_us;
+}
 
 // static inline __s32 i2c_smbus_write_block_data(int file, __u8 command,
 // 					       __u8 length, const __u8 *values)
@@ -35,10 +69,15 @@ int SmbusWriteBlockExecute(int fd,
 {
   int ret = -1;
   int retry_count = 5;
+  unsigned int backoff_us = SMBUS_BACKOFF_MIN_US;
+
+  // The write completes on the bus, only back off when the target did not take it
   do {
     ret = i2c_smbus_write_block_data(fd, command, Length, data);
     retry_count--;
-    MicroSecondDelay(100000, verbose);
+    if (ret && retry_count) {
+      smbus_backoff(&backoff_us, SMBUS_BACKOFF_MAX_US, verbose);
+    }
   } while (ret && retry_count); 
   
   if (ret) {
@@ -48,12 +87,70 @@ int SmbusWriteBlockExecute(int fd,
   return ret;
 }
 
+/**
+  Poll the target for the link layer acknowledgment of an outstanding packet.
+  Acks for packets outside the window are left over from earlier packets and are
+  skipped; the poll interval backs off until an ack arrives or the timeout expires.
+
+  @param  IN unsigned char session_id
+  @param  IN unsigned int base - Oldest unacknowledged sub package
+  @param  IN unsigned int next - Next sub package to be sent
+  @param  IN unsigned int timeout_ms
+  @param  OUT unsigned char *LinkLayerAckBuffer
+  
+  @retval int Acknowledged sub package index, or -1 on timeout or NoACK
+
+**/
+static int
+LinkLayerWaitAcknowledgement(int fd,
+                             unsigned char session_id,
+                             unsigned int base,
+                             unsigned int next,
+                             unsigned int timeout_ms,
+                             unsigned char *LinkLayerAckBuffer,
+                             int verbose)
+{
+  LINK_LAYER_PACKET_ACK_MASTER *ack = (LINK_LAYER_PACKET_ACK_MASTER *)LinkLayerAckBuffer;
+  unsigned long long deadline = smbus_time_us() + ((unsigned long long)timeout_ms * 1000);
+  unsigned int poll_us = SMBUS_ACK_POLL_MIN_US;
+  unsigned int offset = 0;
+  int ret = 0;
+
+  do {
+    ret = LinkLayerReceiveAcknowldgement(fd, session_id, LinkLayerAckBuffer, verbose);
+    // SubPackageIndex is 4 bits wide, compare relative to the window base
+    offset = (ack->SubPackageIndex - base) & 0x0F;
+    if ((ret == 0) && ack->Length && (offset < (next - base))) {
+      if (ack->AckFlag == 1) { // ACK=0x1, NoACK=0x2
+        return base + offset;
+      }
+
+      DEBUG("LinkLayer NAck for SubPackage %d \n", base + offset);
+      return -1;
+    }
+
+    if (smbus_time_us() >= deadline) {
+      break;
+    }
+    smbus_backoff(&poll_us, SMBUS_ACK_POLL_MAX_US, verbose);
+  } while (1);
+
+  DEBUG("LinkLayer Ack timeout after %d ms \n", timeout_ms);
+  return -1;
+}
+
 
 
 /**
-  Sending data by splitting into Number of LinkLayer Packets
+  Sending data by splitting into Number of LinkLayer Packets.
+
+  Up to LINK_LAYER_TX_WINDOW packets are kept in flight.  Acks are cumulative, so
+  an ack for a sub package also covers every earlier one, and progress is driven
+  by the acks alone.  On NoACK or ack timeout the window goes back to the oldest
+  unacknowledged packet and resends from there after an exponential backoff.
 
   @param  DataPacket
+  @param  linklayer_ack_timeout - Time in ms to wait for each ack
   
   @param  int Status
 
@@ -63,20 +160,19 @@ int SendDataPacketThroughLinkLayer(
         int fd,
         unsigned char *DataPacket,
         unsigned int data_payload_length,
-        unsigned int linklayer_ack_delay,
+        unsigned int linklayer_ack_timeout,
         int verbose)
 {   
-  unsigned char *Source = NULL;
   unsigned char LinkLayerAckBuffer[64] = {0};
   unsigned char AckNeeded = 0;
   int package_size = 0;
   int totalPackageCount = 0; 
-  int PackageIndex = 0;
-  int ReSendNeeded = 1;
-  int RemainLength = 0;
+  unsigned int base = 0;
+  unsigned int next = 0;
+  unsigned int backoff_us = SMBUS_BACKOFF_MIN_US;
   int ThisPackageLength = 0;
   int package_retry_count = 0;
-  int ack_retry_count = 0;
+  int acked = 0;
   int ret = 0;
   //This is datalayer session id will increment for every data layer transaction
   unsigned char session_id = 0;
@@ -109,94 +205,68 @@ int SendDataPacketThroughLinkLayer(
     kv_set(key , value, 0, 0);
   }
   
-  Source = DataPacket;
   totalPackageCount = (package_size / LINK_LAYER_MAX_LOAD);
-  RemainLength = package_size;
   
   if((package_size % LINK_LAYER_MAX_LOAD) != 0){
     totalPackageCount++;
   }
   
-  for(PackageIndex = 0; PackageIndex <= totalPackageCount; PackageIndex++) {
-    package_retry_count = 0;
-    
-    if (RemainLength == 0)
-        break; // to break the for loop
-    
-    if (RemainLength >= LINK_LAYER_MAX_LOAD){  
+  while (base < totalPackageCount) {
+    // Fill the window, a packet that does not need an ack is done once it is on the bus
+    ret = 0;
+    while ((next < totalPackageCount) && ((next - base) < LINK_LAYER_TX_WINDOW)) {
+      ThisPackageLength = package_size - (next * LINK_LAYER_MAX_LOAD);
+      if (ThisPackageLength > LINK_LAYER_MAX_LOAD) {
         ThisPackageLength = LINK_LAYER_MAX_LOAD;
-        RemainLength = RemainLength - LINK_LAYER_MAX_LOAD; 
-    } else {
-        ThisPackageLength = RemainLength;
-        RemainLength = 0; 
-    }
-    
-    do {
-      DEBUG("\n");
-      DEBUG("PackageIndex:%d, totalPackageCount:%d, SendPacketThroughLinkLayer %s \n", PackageIndex, totalPackageCount, (package_retry_count ? "retry..." : "") );
-  
-      ReSendNeeded = 1;//ReSendNeeded need to set, if when AckFlag send success ReSendNeeded become 0.  
-      
-      
-      if (package_retry_count) {
-        MicroSecondDelay(200*1000, verbose); // provide delay of 200ms on retrying the same packet.
       }
 
-      ret = SendPacketThroughLinkLayer(fd, session_id, Source, ThisPackageLength,
-               AckNeeded, PackageIndex, totalPackageCount, verbose);
+      DEBUG("\n");
+      DEBUG("PackageIndex:%d, totalPackageCount:%d, SendPacketThroughLinkLayer %s \n", next, totalPackageCount, (package_retry_count ? "retry..." : "") );
+
+      ret = SendPacketThroughLinkLayer(fd, session_id, DataPacket + (next * LINK_LAYER_MAX_LOAD), ThisPackageLength,
+               AckNeeded, next, totalPackageCount, verbose);
       DEBUG("SendPacketThroughLinkLayer ret : %d\n", ret);
-      
-      if (ret == 0) {
-        ack_retry_count = 0;
-        if (AckNeeded == 1) {
-          do {
-            MicroSecondDelay(linklayer_ack_delay*1000, verbose);
-            DEBUG("Get command LinkLayer Ack %s \n", (ack_retry_count ? "retry..." : "") );
-            ret = LinkLayerReceiveAcknowldgement(fd, session_id, LinkLayerAckBuffer, verbose);
-            if (ret) {
-              DEBUG("LinkLayerReceiveAcknowldgement fail \n");
-              ack_retry_count++;
-              continue;
-            }
-                      
-            if( ((LINK_LAYER_PACKET_ACK_MASTER *)LinkLayerAckBuffer)->Length &&  // Length should be valid
-                ((LINK_LAYER_PACKET_ACK_MASTER *)LinkLayerAckBuffer)->AckFlag == 1) { // ACK=0x1, NoACK=0x2
-                ReSendNeeded = 0;
-                break;
-            } else {
-              DEBUG("LinkLayer NAck, or content check fail \n");
-            }
-          
-            ack_retry_count++;
-          } while ( ack_retry_count < 3 );
-          package_retry_count++;
-          
-        } else {
-          // AckNeeded = 0
-          ReSendNeeded = 0;
-        }
-        
-      } else {
-        package_retry_count++;
+      if (ret) {
+        break;
       }
-        
-      // while (ReSendNeeded && (DataPacket->Flag & 0x04)); 
-      // Bit 0, 0 Data, 1 ACK    Bit 1, 0 NoAck 1 ACK    Bit 2 need ACK? 
-    } while ((package_retry_count < 5) && ReSendNeeded); 
-    
-    if (ReSendNeeded) {
+
+      if (AckNeeded == 0) {
+        base = next + 1;
+      }
+      next++;
+    }
+
+    if ((ret == 0) && (base == next)) {
+      continue;
+    }
+
+    if (ret == 0) {
+      DEBUG("Get command LinkLayer Ack for SubPackage %d..%d \n", base, next - 1);
+      acked = LinkLayerWaitAcknowledgement(fd, session_id, base, next, linklayer_ack_timeout,
+                LinkLayerAckBuffer, verbose);
+      if (acked >= 0) {
+        base = acked + 1;
+        package_retry_count = 0;
+        backoff_us = SMBUS_BACKOFF_MIN_US;
+        continue;
+      }
+    }
+
+    // Go back to the oldest unacknowledged packet
+    package_retry_count++;
+    if (package_retry_count >= 5) {
       printf("platfire ack keep busy after retry 5 times, please try later \n");
       return -1;
     }
-    
-    Source += ThisPackageLength;
+
+    smbus_backoff(&backoff_us, SMBUS_BACKOFF_MAX_US, verbose);
+    next = base;
   }
-  
-  
  
-  return ret;
+  return 0;
 }
 
+
 /**
   Function is to send splitted linklayer packets
 
@@ -255,18 +325,35 @@ int SendPacketThroughLinkLayer(
     return ret;
 }
 
+
 static int
-get_linklayer_ack_delay(unsigned char command)
+get_linklayer_ack_timeout(unsigned char command)
 {
-  //unit ms
+  //unit ms, upper bound only, the ack is taken as soon as the target posts it
   switch (command) {
     case CMD_DECOMMSION_REQUST:
-      return 2000; //ami request 2s
+      return 6000; //ami request 2s, 3 polls
     default:
-      return 100; //ami default 100ms
+      return 300; //ami default 100ms, 3 polls
   }
 }
 
+static int
+get_datalayer_response_timeout(unsigned char command)
+{
+  //unit ms, upper bound only, the response is taken as soon as the target posts it
+  switch (command) {
+    case CMD_DECOMMSION_REQUST:
+      return 71000; //ami request 70s
+    case CMD_RECOMMISSION_REQUST:
+      return 16000; //ami request 15s 2022-01-11
+    default:
+      return DATA_LAYER_RESPONSE_TIMEOUT_MS;
+  }
+}
+
+
+
 static unsigned char
 command_mapping_flag(unsigned char command) {
 	
@@ -290,40 +377,27 @@ datalayer_send_receive(unsigned char slot_id,
 {
 	int ret = -1;
   int retry = 3;
-  int delay = 0;
+  unsigned int backoff_us = SMBUS_BACKOFF_MIN_US;
   
   do {
     ret = sent_data_packet(slot_id, fd, command, data_payload, data_payload_length, verbose);
     if (ret) {
       printf("sent_data_packet fail \n");
       retry--;
-      sleep(1);
+      if (retry) {
+        smbus_backoff(&backoff_us, SMBUS_BACKOFF_MAX_US, verbose);
+      }
       continue;
     }
     
-    switch (command) {
-      case CMD_DECOMMSION_REQUST:
-        delay = 70; //ami request
-        break;
-        
-      case CMD_RECOMMISSION_REQUST:
-        delay = 15; //ami request 2022-01-11
-        break;
-        
-      default:
-        delay = 0;
-    }
-    
-    if (delay > 0) {
-      sleep(delay);
-      printf("sleep %ds \n", delay); 
-    }
-    
-    ret = DataLayerReceiveFromPlatFire(slot_id, fd, DataLayerAckBuffer, verbose);
+    // Poll for the response instead of sleeping for the worst case command time
+    ret = datalayer_receive(slot_id, fd, DataLayerAckBuffer, get_datalayer_response_timeout(command), verbose);
     if (ret) {
       printf("DataLayerReceiveFromPlatFire fail \n");
       retry--;
-      sleep(1);
+      if (retry) {
+        smbus_backoff(&backoff_us, SMBUS_BACKOFF_MAX_US, verbose);
+      }
       continue;
     }
     
@@ -336,6 +410,8 @@ datalayer_send_receive(unsigned char slot_id,
   return 0;
 }
 
+
+
 int
 sent_data_packet(unsigned char slot_id,
                  int fd,
@@ -346,7 +422,7 @@ sent_data_packet(unsigned char slot_id,
 {
   unsigned char data[DATA_LAYER_MAX_PAYLOAD] = {0};
   int index = 0;
-  unsigned int linklayer_ack_delay = get_linklayer_ack_delay(command);
+  unsigned int linklayer_ack_timeout = get_linklayer_ack_timeout(command);
   
   if (data_payload_length > DATA_LAYER_MAX_PAYLOAD) {
     printf("the data length > DATA_LAYER_MAX_PAYLOAD(%d) \n", DATA_LAYER_MAX_PAYLOAD);
@@ -396,10 +472,23 @@ sent_data_packet(unsigned char slot_id,
     DEBUG("\n");
   }
   
-	return SendDataPacketThroughLinkLayer(slot_id, fd, data, data_payload_length, linklayer_ack_delay, verbose);
+	return SendDataPacketThroughLinkLayer(slot_id, fd, data, data_payload_length, linklayer_ack_timeout, verbose);
 }
 
-int DataLayerReceiveFromPlatFire(unsigned char slot_id, int fd, unsigned char *DataLayerAckBuffer, int verbose)
+/**
+  Receive the data layer response.  Each link layer packet is read as soon as the
+  target posts it, polling with backoff while nothing new is available, until no
+  packet has arrived for timeout_ms.  Link layer acks left over from the request
+  are skipped, only data packets make up the response.
+
+  @param  IN unsigned int timeout_ms
+  @param  OUT unsigned char *DataLayerAckBuffer
+  
+  @retval int 0 - SUCCESS, -1 - FAIL
+
+**/
+static int
+datalayer_receive(unsigned char slot_id, int fd, unsigned char *DataLayerAckBuffer, unsigned int timeout_ms, int verbose)
 {
 DEBUG("\n--------------------------DataLayerReceive--------------------------\n");
   unsigned char RecieveDataBuffer[512] = { 0 }; 
@@ -411,7 +500,9 @@ DEBUG("\n--------------------------DataLayerReceive--------------------------\n"
   char value[128] = {0};
   unsigned char session_id = 0;
   unsigned char checksum = 0;
-  int retry = 0;
+  unsigned int poll_us = SMBUS_ACK_POLL_MIN_US;
+  int last_index = -1;
+  unsigned long long deadline = smbus_time_us() + ((unsigned long long)timeout_ms * 1000);
   
   snprintf(key, sizeof(key), PROT_SESSION_KEY, slot_id);
   if (kv_get(key, value, NULL, 0)) {
@@ -426,18 +517,25 @@ DEBUG("\n--------------------------DataLayerReceive--------------------------\n"
   }
 
   do {
-    MicroSecondDelay(200*1000, verbose);  //please add 200ms delay to receive DataLayer
     ret = LinkLayerReceiveAcknowldgement(fd, session_id, RecieveBuffer, verbose);
     if (ret) {
       DEBUG("LinkLayerReceiveAcknowldgement fail \n");
-      if (retry < 5) {
-        retry ++;
-        continue;
-      } else {
-        printf("get response fail after 5 retry \n");
+      if (smbus_time_us() >= deadline) {
+        printf("get response fail after %d ms \n", timeout_ms);
         return -1;
       }
-
+      smbus_backoff(&poll_us, SMBUS_ACK_POLL_MAX_US, verbose);
+      continue;
+    }
+    if (LinkLayerPkgBuffer->PackageType) {
+      // Still the link layer ack of the request, the response has not been posted yet
+      DEBUG("link layer ack, waiting for the data packet \n");
+      if (smbus_time_us() >= deadline) {
+        printf("get response fail after %d ms \n", timeout_ms);
+        return -1;
+      }
+      smbus_backoff(&poll_us, SMBUS_ACK_POLL_MAX_US, verbose);
+      continue;
     }
     DEBUG("LinkLayerPkgBuffer->AckNeeded = %u...", LinkLayerPkgBuffer->AckNeeded);
     if(LinkLayerPkgBuffer->AckNeeded){ //If AckNeeded bit set, need to send acknowldgement
@@ -454,6 +552,20 @@ DEBUG("\n--------------------------DataLayerReceive--------------------------\n"
     if(LinkLayerPkgBuffer->SubPackageIndex == (LinkLayerPkgBuffer->AckFlag - 1)){ 
       break;
     }  
+
+    if (LinkLayerPkgBuffer->SubPackageIndex != last_index) {
+      // The target is streaming, poll quickly for the next packet
+      last_index = LinkLayerPkgBuffer->SubPackageIndex;
+      poll_us = SMBUS_ACK_POLL_MIN_US;
+      deadline = smbus_time_us() + ((unsigned long long)timeout_ms * 1000);
+    } else {
+      // Same packet again, the target has not moved on yet
+      if (smbus_time_us() >= deadline) {
+        printf("get response fail after %d ms \n", timeout_ms);
+        return -1;
+      }
+      smbus_backoff(&poll_us, SMBUS_ACK_POLL_MAX_US, verbose);
+    }
   } while (1);
   
   DEBUG("\nRECEIVED DATA BUFFER\n");
@@ -482,6 +594,20 @@ DEBUG("\n--------------------------DataLayerReceive--------------------------\n"
   return 0;
 }
 
+/**
+  This function is use to receive back the data Layer packet
+
+  @param  none
+  
+  @param  none
+
+**/
+int DataLayerReceiveFromPlatFire(unsigned char slot_id, int fd, unsigned char *DataLayerAckBuffer, int verbose)
+{
+  return datalayer_receive(slot_id, fd, DataLayerAckBuffer, DATA_LAYER_RESPONSE_TIMEOUT_MS, verbose);
+}
+
+
 /**
   LinkLayer Send Acknowledgment
 
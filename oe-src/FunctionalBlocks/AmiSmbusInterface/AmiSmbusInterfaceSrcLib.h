@@ -9,6 +9,19 @@
 #define LINK_LAYER_MAX_LOAD             (30)      // include 1 byte CheckSum
 #define LINK_LAYER_MAX_RECEIVE_LOAD     (28)
 
+// Link layer packets in flight before waiting for an ack, the target acks cumulatively
+#ifndef LINK_LAYER_TX_WINDOW
+#define LINK_LAYER_TX_WINDOW            (1)
+#endif
+#if (LINK_LAYER_TX_WINDOW < 1) || (LINK_LAYER_TX_WINDOW > 15)
+#error "LINK_LAYER_TX_WINDOW must fit the 4 bit SubPackageIndex"
+#endif
+#define DATA_LAYER_RESPONSE_TIMEOUT_MS  (1000)
+#define SMBUS_BACKOFF_MIN_US            (1000)     // retry backoff after a failed transfer
+#define SMBUS_BACKOFF_MAX_US            (200000)
+#define SMBUS_ACK_POLL_MIN_US           (200)      // ack/response poll interval
+#define SMBUS_ACK_POLL_MAX_US           (50000)
+
 enum {
   ACK_CMD_UNSUPPORTED = 0x01,
   ACK_BUSY_FLAG = 0x02,
@@ -123,6 +136,7 @@ typedef struct {
   Sending data by splitting into number of LinkLayer Packets
 
   @param  IN DataPacket - Buffer contains data layer structure data
+  @param  IN linklayer_ack_timeout - Time in ms to wait for each ack
   
   @retval int 0 - SUCCESS 
               1 - FAIL
@@ -133,7 +147,7 @@ int SendDataPacketThroughLinkLayer(
         int fd,
         unsigned char *DataPacket,
         unsigned int data_payload_length,
-        unsigned int linklayer_ack_delay,
+        unsigned int linklayer_ack_timeout,
         int verbose
         );
 
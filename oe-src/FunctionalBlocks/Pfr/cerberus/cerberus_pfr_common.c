@@ -1,5 +1,6 @@
 #if CONFIG_CERBERUS_PFR_SUPPORT
 
+#include <stdbool.h>
 #include "pfr/pfr_common.h"
 #include "pfr/pfr_util.h"
 #include "cerberus_pfr_authentication.h"
@@ -11,6 +12,8 @@
 #include "cerberus_pfr_key_cancellation.h"
 #include "state_machine/common_smc.h"
 #include "crypto/rsa.h"
+#include "flash/flash_aspeed.h"
+#include "keystore/KeystoreManager.h"
 
 #if PF_STATUS_DEBUG
 #ifndef DEBUG_PRINTF
@@ -384,6 +387,12 @@ void init_lib_pfr_manifest(struct pfr_manifest *pfr_manifest,
 int get_rsa_public_key(uint8_t flash_id, uint32_t address, struct rsa_public_key *public_key)
 {
 	int status;
+	// Keys on the RoT internal flash only change through the keystore, which drops the cache
+	bool cacheable = (flash_id == ROT_INTERNAL_INTEL_STATE) || (flash_id == ROT_INTERNAL_KEY);
+
+	if (cacheable && (keystore_cache_get_public_key(flash_id, address, public_key) == Success))
+		return Success;
+
     status = pfr_spi_read(flash_id, address, sizeof(struct rsa_public_key)-1, public_key);
    	if(status != Success)
     {
@@ -391,6 +400,8 @@ int get_rsa_public_key(uint8_t flash_id, uint32_t address, struct rsa_public_key
 		return Failure;
     }
     
+	if (cacheable)
+		keystore_cache_put_public_key(flash_id, address, public_key);
 
     return status;
 }
@@ -15,6 +15,7 @@
 #include "cerberus_pfr_verification.h"
 #include "include/SmbusMailBoxCom.h"
 #include "flash/flash_aspeed.h"
+#include "keystore/KeystoreManager.h"
 
 #undef DEBUG_PRINTF
 #if PFR_AUTHENTICATION_DEBUG
@@ -171,6 +172,7 @@ int cerberus_provisioning_root_key_action(struct pfr_manifest *manifest){
 		CerberusProvisionRootKeyHash();
 		//write root key to d0200
 
+		keystore_cache_invalidate();
 		pfr_spi_write(ROT_INTERNAL_INTEL_STATE, CERBERUS_ROOT_KEY_ADDRESS, sizeof(root_key), &root_key);
 
 	}else{
@@ -122,6 +122,8 @@ int cerberus_verify_regions(struct manifest *manifest)
 	uint32_t start_address;
 	uint32_t end_address;
 	uint8_t *hashStorage = getNewHashStorage();
+	struct rsa_engine *rsa = getRsaEngineInstance();
+	struct pfr_hash_region region;
 	struct CERBERUS_PFM_RW_REGION rw_region_data;
 	struct CERBERUS_SIGN_IMAGE_HEADER sign_region_header;
 
@@ -164,19 +166,13 @@ int cerberus_verify_regions(struct manifest *manifest)
 		read_address += sizeof(end_address);
 		printk("end_address:%x \r\n",end_address);
 
-		pfr_manifest->flash->device_id[0] = pfr_manifest->flash_id;	  // device_id will be changed by save_key function
-		status = flash_verify_contents((struct flash *)pfr_manifest->flash,
-					       start_address,
-					       end_address - start_address + sizeof(uint8_t),
-					       get_hash_engine_instance(),
-					       HASH_TYPE_SHA256,
-					       getRsaEngineInstance(),
-					       signature,
-					       256,
-					       &pub_key,
-					       hashStorage,
-					       256
-					       );
+		region.start_address = start_address;
+		region.length = end_address - start_address + sizeof(uint8_t);
+		status = pfr_spi_hash_regions(pfr_manifest->flash_id, &region, 1, HASH_TYPE_SHA256,
+					      hashStorage, SHA256_DIGEST_LENGTH);
+		if (status == Success)
+			status = rsa->sig_verify(rsa, &pub_key, signature, 256, hashStorage,
+						 SHA256_DIGEST_LENGTH);
 		if (status == Success) {
 			int get_key_id = 0xFF;
 			int last_key_id = 0xFF;
@@ -35,7 +35,7 @@ int pfr_recovery_verify(struct pfr_manifest *manifest){
     manifest->address = read_address;
 
     //Block0-Block1 verifcation
-    status = manifest->base->verify(manifest, manifest->hash,manifest->verification->base, manifest->pfr_hash->hash_out, manifest->pfr_hash->length);
+    status = intel_pfr_manifest_verify((struct manifest *)manifest, manifest->hash,manifest->verification->base, manifest->pfr_hash->hash_out, manifest->pfr_hash->length);
     if(status != Success){
         DEBUG_PRINTF("Verify recovery failed\r\n");
         return Failure;
@@ -51,7 +51,7 @@ int pfr_recovery_verify(struct pfr_manifest *manifest){
     manifest->address += PFM_SIG_BLOCK_SIZE;
 
     //manifest verifcation
-    status = manifest->base->verify(manifest,manifest->hash,manifest->verification->base, manifest->pfr_hash->hash_out, manifest->pfr_hash->length);
+    status = intel_pfr_manifest_verify((struct manifest *)manifest, manifest->hash,manifest->verification->base, manifest->pfr_hash->hash_out, manifest->pfr_hash->length);
     if(status != Success){
         DEBUG_PRINTF("Verify recovery pfm failed\r\n");
         return Failure;
@@ -88,7 +88,7 @@ int pfr_active_verify(struct pfr_manifest *manifest)
 
     DEBUG_PRINTF("PFM Verification\r\n");
 
-    status = manifest->base->verify(manifest,manifest->hash,manifest->verification->base, manifest->pfr_hash->hash_out, manifest->pfr_hash->length);
+    status = intel_pfr_manifest_verify((struct manifest *)manifest, manifest->hash,manifest->verification->base, manifest->pfr_hash->hash_out, manifest->pfr_hash->length);
     if(status != Success){
         DEBUG_PRINTF("Verify active pfm failed\r\n");
         SetMajorErrorCode(manifest->image_type == BMC_TYPE ? BMC_AUTH_FAIL : PCH_AUTH_FAIL);
@@ -0,0 +1,340 @@
+//***********************************************************************//
+//*                                                                     *//
+//*                      Copyright © 2022 AMI                           *//
+//*                                                                     *//
+//*        All rights reserved. Subject to AMI licensing agreement.     *//
+//*                                                                     *//
+//***********************************************************************//
+#if CONFIG_INTEL_PFR_SUPPORT
+#include <stddef.h>
+#include <string.h>
+#include "state_machine/common_smc.h"
+#include "pfr/pfr_common.h"
+#include "pfr/pfr_util.h"
+#include "intel_pfr_definitions.h"
+#include "intel_pfr_provision.h"
+#include "intel_pfr_verification.h"
+#include "intel_pfr_pfm_manifest.h"
+#include "intel_pfr_capsule_verdict.h"
+
+#undef DEBUG_PRINTF
+#if PFR_AUTHENTICATION_DEBUG
+#define DEBUG_PRINTF printk
+#else
+#define DEBUG_PRINTF(...)
+#endif
+
+/*
+ * Capsule verdict cache.
+ *
+ * Authenticating a BMC or PCH update capsule hashes its whole protected content, which is several
+ * megabytes of SPI reads.  Once a capsule has passed, the authenticated Block0 is sealed to the RoT
+ * internal state partition together with the capsule location.  A later authentication of the
+ * same capsule still checks key cancellation and the Block1 signature chain, but skips the
+ * protected content hash when the active PFM has the SPI filter write protecting the whole
+ * capsule, so nothing but the RoT could have written it since.  The RoT drops the verdict before
+ * writing to a capsule, and a capsule is hashed again after CAPSULE_VERDICT_REUSE_LIMIT reuses.
+ * Staging capsules are normally host writable and are therefore always hashed.
+ *
+ * Every change appends a newly sealed copy of the table to the next erased slot of its sector and
+ * the last valid slot is the current table, so the sector is only erased once all slots are used.
+ */
+
+static CAPSULE_VERDICT capsule_verdict;
+static bool capsule_verdict_loaded;
+static uint32_t capsule_verdict_next_slot;
+
+static int capsule_verdict_seal_digest(struct pfr_manifest *manifest, CAPSULE_VERDICT *table, uint8_t *digest)
+{
+	return manifest->hash->calculate_sha256(manifest->hash, (uint8_t *)table,
+		offsetof(CAPSULE_VERDICT, Seal), digest, SHA256_DIGEST_LENGTH);
+}
+
+static bool capsule_verdict_type_supported(uint32_t image_type, uint32_t pc_type)
+{
+	if (image_type == BMC_TYPE)
+		return pc_type == PFR_BMC_UPDATE_CAPSULE;
+	if (image_type == PCH_TYPE)
+		return pc_type == PFR_PCH_UPDATE_CAPSULE;
+
+	return false;
+}
+
+/**
+    Function to load the last sealed capsule verdict table, starting an empty table if none are valid
+
+    @Param  manifest    PFR manifest, for the hash engine
+**/
+static void capsule_verdict_load(struct pfr_manifest *manifest)
+{
+	CAPSULE_VERDICT stored;
+	uint8_t seal[SHA256_DIGEST_LENGTH];
+	uint32_t slot;
+
+	if (capsule_verdict_loaded)
+		return;
+
+	memset(&capsule_verdict, 0, sizeof(capsule_verdict));
+	capsule_verdict.Magic = CAPSULE_VERDICT_MAGIC;
+	capsule_verdict.Version = CAPSULE_VERDICT_VERSION;
+
+	// Slots fill in order, a torn write leaves an unsealed slot that is skipped
+	for (slot = 0; slot < CAPSULE_VERDICT_SLOTS; slot++) {
+		if (pfr_spi_read(ROT_INTERNAL_STATE, CAPSULE_VERDICT_ADDRESS + slot * CAPSULE_VERDICT_SLOT_SIZE,
+			sizeof(stored), (uint8_t *)&stored) != Success) {
+			// Can't tell which slots are erased, start over with the next store
+			slot = CAPSULE_VERDICT_SLOTS;
+			break;
+		}
+
+		if (stored.Magic == 0xFFFFFFFF)
+			break;
+
+		if (stored.Magic == CAPSULE_VERDICT_MAGIC &&
+		    stored.Version == CAPSULE_VERDICT_VERSION &&
+		    capsule_verdict_seal_digest(manifest, &stored, seal) == Success &&
+		    compare_buffer(seal, stored.Seal, SHA256_DIGEST_LENGTH) == Success)
+			memcpy(&capsule_verdict, &stored, sizeof(capsule_verdict));
+	}
+	capsule_verdict_next_slot = slot;
+
+	capsule_verdict_loaded = true;
+}
+
+/**
+    Function to seal the capsule verdict table into the next free slot of its sector, the sector
+    is only erased once every slot has been used
+
+    @Param  manifest    PFR manifest, for the hash engine
+
+    @retval int         Success or Failure
+**/
+static int capsule_verdict_store(struct pfr_manifest *manifest)
+{
+	int status = 0;
+
+	status = capsule_verdict_seal_digest(manifest, &capsule_verdict, capsule_verdict.Seal);
+	if (status != Success)
+		return Failure;
+
+	if (capsule_verdict_next_slot >= CAPSULE_VERDICT_SLOTS) {
+		status = pfr_spi_erase_4k(ROT_INTERNAL_STATE, CAPSULE_VERDICT_ADDRESS);
+		if (status != Success)
+			return Failure;
+		capsule_verdict_next_slot = 0;
+	}
+
+	return pfr_spi_write(ROT_INTERNAL_STATE, CAPSULE_VERDICT_ADDRESS + capsule_verdict_next_slot++ * CAPSULE_VERDICT_SLOT_SIZE,
+		sizeof(capsule_verdict), (uint8_t *)&capsule_verdict);
+}
+
+/**
+    Function to check whether the SPI filter write protects a capsule.  The active PFM is walked
+    the same way init_SPI_RW_region programs the filter from it.
+
+    @Param  image_type  BMC_TYPE or PCH_TYPE
+    @Param  address     Capsule start offset
+    @Param  length      Capsule length, signature block included
+
+    @retval bool        true if no host writable region overlaps the capsule
+**/
+static bool capsule_verdict_write_protected(uint32_t image_type, uint32_t address, uint32_t length)
+{
+	PFM_SPI_DEFINITION spi_definition;
+	PFM_STRUCTURE_1 pfm_data;
+	uint32_t pfm_address = 0;
+	uint32_t position;
+	uint32_t end;
+
+	get_provision_data_in_flash(image_type == BMC_TYPE ? BMC_ACTIVE_PFM_OFFSET : PCH_ACTIVE_PFM_OFFSET,
+		(uint8_t *)&pfm_address, sizeof(pfm_address));
+
+	if (pfr_spi_read(image_type, pfm_address + PFM_SIG_BLOCK_SIZE, sizeof(PFM_STRUCTURE_1), (uint8_t *)&pfm_data) != Success ||
+	    pfm_data.PfmTag != PFMTAG)
+		return false;
+
+	position = pfm_address + PFM_SIG_BLOCK_SIZE + sizeof(PFM_STRUCTURE_1);
+	end = pfm_address + PFM_SIG_BLOCK_SIZE + pfm_data.Length;
+
+	while (position < end) {
+		if (pfr_spi_read(image_type, position, sizeof(spi_definition), (uint8_t *)&spi_definition) != Success)
+			return false;
+
+		if (spi_definition.PFMDefinitionType != PCH_PFM_SPI_REGION)
+			break;
+
+		if (spi_definition.ProtectLevelMask.WriteAllowed &&
+		    spi_definition.RegionStartAddress < (address + length) &&
+		    spi_definition.RegionEndAddress > address)
+			return false;
+
+		position += spi_definition.HashAlgorithmInfo.SHA256HashPresent ? 48 : 16;
+	}
+
+	return true;
+}
+
+static CAPSULE_VERDICT_ENTRY *capsule_verdict_find(uint32_t image_type, uint32_t address)
+{
+	int i;
+
+	for (i = 0; i < CAPSULE_VERDICT_MAX_ENTRIES; i++) {
+		if (capsule_verdict.Entry[i].Address == address && capsule_verdict.Entry[i].ImageType == image_type)
+			return &capsule_verdict.Entry[i];
+	}
+
+	return NULL;
+}
+
+static CAPSULE_VERDICT_ENTRY *capsule_verdict_free_entry(uint32_t image_type)
+{
+	int i;
+
+	for (i = 0; i < CAPSULE_VERDICT_MAX_ENTRIES; i++) {
+		if (!capsule_verdict.Entry[i].Address)
+			return &capsule_verdict.Entry[i];
+	}
+
+	return &capsule_verdict.Entry[image_type % CAPSULE_VERDICT_MAX_ENTRIES];
+}
+
+/**
+    Function to check whether the protected content of an authenticated capsule can skip hashing
+
+    @Param  manifest    PFR manifest with address pointing to the capsule signature block
+    @Param  pc_type     Protected content type from Block0
+    @Param  block0      Block0 of the capsule, already checked against the Block1 signature
+
+    @retval bool        true if the capsule was hashed before and can't have changed since
+**/
+bool capsule_verdict_lookup(struct pfr_manifest *manifest, uint32_t pc_type, uint8_t *block0)
+{
+	PFR_AUTHENTICATION_BLOCK0 *block0_buffer = (PFR_AUTHENTICATION_BLOCK0 *)block0;
+	uint8_t block0_hash[SHA256_DIGEST_LENGTH];
+	CAPSULE_VERDICT_ENTRY *entry;
+
+	if (!capsule_verdict_type_supported(manifest->image_type, pc_type))
+		return false;
+
+	capsule_verdict_load(manifest);
+
+	entry = capsule_verdict_find(manifest->image_type, manifest->address);
+	if (entry == NULL || entry->PcLength != block0_buffer->PcLength ||
+	    entry->ReusesSinceFullVerify >= CAPSULE_VERDICT_REUSE_LIMIT)
+		return false;
+
+	if (manifest->hash->calculate_sha256(manifest->hash, block0, sizeof(PFR_AUTHENTICATION_BLOCK0),
+		block0_hash, sizeof(block0_hash)) != Success ||
+	    compare_buffer(block0_hash, entry->Block0Hash, SHA256_DIGEST_LENGTH) != Success)
+		return false;
+
+	if (!capsule_verdict_write_protected(manifest->image_type, manifest->address, PFM_SIG_BLOCK_SIZE + entry->PcLength))
+		return false;
+
+	entry->ReusesSinceFullVerify++;
+	if (capsule_verdict_store(manifest) != Success)
+		return false;
+
+	DEBUG_PRINTF("Capsule verdict reused\r\n");
+	return true;
+}
+
+/**
+    Function to record a capsule whose protected content hash matched its Block0
+
+    @Param  manifest    PFR manifest with address pointing to the capsule signature block
+    @Param  pc_type     Protected content type from Block0
+    @Param  block0      Authenticated Block0 of the capsule
+**/
+void capsule_verdict_record(struct pfr_manifest *manifest, uint32_t pc_type, uint8_t *block0)
+{
+	PFR_AUTHENTICATION_BLOCK0 *block0_buffer = (PFR_AUTHENTICATION_BLOCK0 *)block0;
+	CAPSULE_VERDICT_ENTRY recorded;
+	CAPSULE_VERDICT_ENTRY *entry;
+
+	if (!capsule_verdict_type_supported(manifest->image_type, pc_type))
+		return;
+
+	// Host writable capsules could change right after this check
+	if (!capsule_verdict_write_protected(manifest->image_type, manifest->address, PFM_SIG_BLOCK_SIZE + block0_buffer->PcLength))
+		return;
+
+	memset(&recorded, 0, sizeof(recorded));
+	if (manifest->hash->calculate_sha256(manifest->hash, block0, sizeof(PFR_AUTHENTICATION_BLOCK0),
+		recorded.Block0Hash, sizeof(recorded.Block0Hash)) != Success)
+		return;
+
+	recorded.ImageType = manifest->image_type;
+	recorded.Address = manifest->address;
+	recorded.PcLength = block0_buffer->PcLength;
+
+	capsule_verdict_load(manifest);
+
+	entry = capsule_verdict_find(manifest->image_type, manifest->address);
+	if (entry == NULL)
+		entry = capsule_verdict_free_entry(manifest->image_type);
+	else if (!memcmp(entry, &recorded, sizeof(recorded)))
+		return;		// Already recorded with a fresh reuse count
+
+	memcpy(entry, &recorded, sizeof(recorded));
+	capsule_verdict_store(manifest);
+}
+
+/**
+    Function to record a capsule the RoT just copied from a staging capsule that passed
+    authentication, so its first verification after the copy doesn't hash it again
+
+    @Param  manifest    PFR manifest of the update, image_type selecting the flash
+    @Param  address     Offset the capsule was copied to and verified at
+
+    @retval int         Success or Failure
+**/
+int capsule_verdict_record_copy(struct pfr_manifest *manifest, uint32_t address)
+{
+	uint8_t block0[sizeof(PFR_AUTHENTICATION_BLOCK0)];
+	uint32_t manifest_address = manifest->address;
+	int status = 0;
+
+	status = pfr_spi_read(manifest->image_type, address, sizeof(block0), block0);
+	if (status != Success)
+		return Failure;
+
+	manifest->address = address;
+	capsule_verdict_record(manifest, ((PFR_AUTHENTICATION_BLOCK0 *)block0)->PcType, block0);
+	manifest->address = manifest_address;
+
+	return Success;
+}
+
+/**
+    Function to drop the capsule verdicts of a flash before the RoT writes to it
+
+    @Param  image_type  BMC_TYPE or PCH_TYPE
+
+    @retval int         Success or Failure
+**/
+int capsule_verdict_invalidate(uint32_t image_type)
+{
+	struct pfr_manifest *manifest = get_pfr_manifest();
+	bool dropped = false;
+	int i;
+
+	if (image_type != BMC_TYPE && image_type != PCH_TYPE)
+		return Failure;
+
+	capsule_verdict_load(manifest);
+
+	for (i = 0; i < CAPSULE_VERDICT_MAX_ENTRIES; i++) {
+		if (capsule_verdict.Entry[i].Address && capsule_verdict.Entry[i].ImageType == image_type) {
+			memset(&capsule_verdict.Entry[i], 0, sizeof(capsule_verdict.Entry[i]));
+			dropped = true;
+		}
+	}
+
+	if (!dropped)
+		return Success;
+
+	return capsule_verdict_store(manifest);
+}
+
+#endif
@@ -0,0 +1,49 @@
+//***********************************************************************//
+//*                                                                     *//
+//*                      Copyright © 2022 AMI                           *//
+//*                                                                     *//
+//*        All rights reserved. Subject to AMI licensing agreement.     *//
+//*                                                                     *//
+//***********************************************************************//
+
+#ifndef INTEL_PFR_CAPSULE_VERDICT_H_
+#define INTEL_PFR_CAPSULE_VERDICT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pfr/pfr_common.h"
+#include "intel_pfr_definitions.h"
+
+#define CAPSULE_VERDICT_MAGIC		0x43564454	// "CVDT"
+#define CAPSULE_VERDICT_VERSION		2
+#define CAPSULE_VERDICT_MAX_ENTRIES	4
+#define CAPSULE_VERDICT_SLOT_SIZE	0x100		// One sealed table per slot, must hold CAPSULE_VERDICT
+#define CAPSULE_VERDICT_SLOTS		(CAPSULE_VERDICT_SIZE / CAPSULE_VERDICT_SLOT_SIZE)
+
+#pragma pack(1)
+
+typedef struct _CAPSULE_VERDICT_ENTRY {
+	uint8_t  ImageType;
+	uint8_t  ReusesSinceFullVerify;
+	uint8_t  Reserved[2];
+	uint32_t Address;			// Capsule signature block, 0 for an unused entry
+	uint32_t PcLength;
+	uint8_t  Block0Hash[SHA256_DIGEST_LENGTH];	// Authenticated Block0 holding the protected content hash
+} CAPSULE_VERDICT_ENTRY;
+
+typedef struct _CAPSULE_VERDICT {
+	uint32_t Magic;
+	uint8_t  Version;
+	uint8_t  Reserved[3];
+	CAPSULE_VERDICT_ENTRY Entry[CAPSULE_VERDICT_MAX_ENTRIES];
+	uint8_t  Seal[SHA256_DIGEST_LENGTH];		// SHA256 over everything above
+} CAPSULE_VERDICT;
+
+#pragma pack()
+
+bool capsule_verdict_lookup(struct pfr_manifest *manifest, uint32_t pc_type, uint8_t *block0);
+void capsule_verdict_record(struct pfr_manifest *manifest, uint32_t pc_type, uint8_t *block0);
+int capsule_verdict_record_copy(struct pfr_manifest *manifest, uint32_t address);
+int capsule_verdict_invalidate(uint32_t image_type);
+
+#endif /*INTEL_PFR_CAPSULE_VERDICT_H_*/
@@ -13,6 +13,7 @@
 
 extern struct pfr_keystore *get_pfr_keystore();
 extern struct pfr_signature_verification *get_pfr_signature_verification();
+#if MANIFEST_INTERFACE_SUPPORT
 /**
  * Verify if the manifest is valid.
  *
@@ -147,6 +148,7 @@ void init_manifest(struct manifest *manifest){
     manifest->get_signature = manifest_get_signature;
     manifest->is_empty = is_manifest_empty;
 }
+#endif
 
 /**
  * Verify if the recovery image is valid.
@@ -168,6 +170,7 @@ int recovery_verify (struct recovery_image *image, struct hash_engine *hash,
     return intel_pfr_recovery_verify (image,hash,verification, hash_out, hash_length, pfm);
 }
 
+#if MANIFEST_INTERFACE_SUPPORT
 /**
  * Get the SHA-256 hash of the recovery image data, not including the signature.
  *
@@ -224,15 +227,18 @@ int recovery_apply_to_flash (struct recovery_image *image, struct spi_flash *fla
     return intel_pfr_recover_update_action(pfr_manifest);
 
 }
+#endif
 
 void init_recovery_manifest(struct recovery_image *image){
     image->verify = recovery_verify;
+#if MANIFEST_INTERFACE_SUPPORT
     image->get_hash = recovery_get_hash;
     image->get_version = recovery_get_version;
     image->apply_to_flash = recovery_apply_to_flash;
-
+#endif
 }
 
+#if MANIFEST_INTERFACE_SUPPORT
 /**
  * Get the total size of the firmware image.
  *
@@ -273,6 +279,7 @@ struct firmware_header* firmware_image_get_firmware_header (struct firmware_imag
 	ARG_UNUSED(fw);
 	return NULL;
 }
+#endif
 
 /**
  * Verify the complete firmware image.  All components in the image will be fully validated.
@@ -356,7 +363,9 @@ void init_lib_pfr_manifest(struct pfr_manifest *pfr_manifest,
     pfr_manifest->update_fw = update_fw;
     pfr_manifest->active_image_base = active_image;
 
+#if MANIFEST_INTERFACE_SUPPORT
     init_manifest(manifest);
+#endif
     init_recovery_manifest(recovery_base);
     init_update_fw_manifest(update_fw->base);
     init_signature_verifcation(pfr_manifest->verification->base);
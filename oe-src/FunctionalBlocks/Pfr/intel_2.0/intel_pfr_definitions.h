@@ -47,7 +47,39 @@
 #define SMBUS_MAILBOX_SUPPORT       1
 #define PFR_AUTO_PROVISION 			1
 #define UART_ENABLE					1
-
+#define MEASUREMENT_CACHE_SUPPORT	1
+#define UFM_POLICY_SHADOW_SUPPORT	1
+#define UPDATE_CHECKPOINT_SUPPORT	1
+#define CAPSULE_VERDICT_SUPPORT		1
+#define NESTED_PFM_DIGEST_SUPPORT	1
+
+
+#define ROT_ACTIVE_REGION_LENGTH	0x60000
+
+//RoT update into the inactive ABR slot, needs a board whose recovery partition is the ABR alternate slot
+#ifndef ROT_AB_UPDATE_SUPPORT
+#define ROT_AB_UPDATE_SUPPORT		0
+#endif
+
+//struct manifest entries and the recovery_image entries besides verify, nothing calls them for Intel PFR
+#ifndef MANIFEST_INTERFACE_SUPPORT
+#define MANIFEST_INTERFACE_SUPPORT	0
+#endif
+
+//Measurement cache, kept on the RoT internal state partition
+#define MEASUREMENT_CACHE_ADDRESS	0x1000		// BMC at 0x1000, PCH at 0x2000
+#define MEASUREMENT_CACHE_SIZE		0x1000
+#define MEASUREMENT_CACHE_FULL_VERIFY_INTERVAL	16	// Force full re-hash every N boots, 0 to disable the cache
+
+//Authenticated capsule verdicts, kept on the RoT internal state partition
+#define CAPSULE_VERDICT_ADDRESS		0x3000
+#define CAPSULE_VERDICT_SIZE		0x1000
+#define CAPSULE_VERDICT_REUSE_LIMIT	16		// Force full re-hash after N reuses
+
+//Update and recovery progress checkpoint, kept on the RoT internal state partition
+#define UPDATE_CHECKPOINT_ADDRESS	0x8000
+#define UPDATE_CHECKPOINT_SIZE		0x1000
+#define UPDATE_CHECKPOINT_INTERVAL	0x10000		// Bytes of the target region between two checkpoints
 
 //HROT FW version
 #define CPLD_RELEASE_VERSION	1
@@ -10,6 +10,7 @@
 #include "intel_pfr_provision.h"
 #include "intel_pfr_definitions.h"
 #include "intel_pfr_verification.h"
+#include "intel_pfr_ufm_policy.h"
 #include "CommonFlash/CommonFlash.h"
 #include "state_machine/common_smc.h"
 #include "flash/flash_aspeed.h"
@@ -89,6 +90,22 @@ int verify_csk_key_id(struct pfr_manifest *manifest, uint32_t key_id)
 	if(!ufm_offset)
 		 return Failure;
 
+#if UFM_POLICY_SHADOW_SUPPORT
+	bool cancelled = false;
+
+	status = ufm_policy_key_cancelled(ufm_offset, key_id, &cancelled);
+	if (status != Success) {
+		DEBUG_PRINTF("Invalid Key Id\r\n");
+		return Failure;
+	}
+
+	if (cancelled) {
+		DEBUG_PRINTF("This PFR CSK Key Was cancelled..!Can't Proceed with verify with this key Id: %d\r\n",key_id);
+		return Failure;
+	}
+
+	return Success;
+#else
 	status = ufm_read(PROVISION_UFM,ufm_offset, old_key_id, sizeof(old_key_id));
 	if (status != Success)
 		return Failure;
@@ -105,6 +122,7 @@ int verify_csk_key_id(struct pfr_manifest *manifest, uint32_t key_id)
 	}
 
 	return Success;
+#endif
 
 }
 
@@ -127,6 +145,21 @@ int cancel_csk_key_id(struct pfr_manifest *manifest, uint32_t key_id)
 
 	byte_no = key_id / 8;
 	bit_no = key_id % 8;
+
+#if UFM_POLICY_SHADOW_SUPPORT
+	bool cancelled = false;
+
+	status = ufm_policy_key_cancelled(ufm_offset, key_id, &cancelled);
+	if (status != Success) {
+		DEBUG_PRINTF("Invalid Key Id\r\n");
+		return Failure;
+	}
+
+	// Already cancelled, no need to rewrite the provisioning UFM
+	if (cancelled)
+		return Success;
+#endif
+
 	ufm_offset = ufm_offset + byte_no;
 
 	//store policy data from flash part
@@ -0,0 +1,325 @@
+//***********************************************************************//
+//*                                                                     *//
+//*                      Copyright © 2022 AMI                           *//
+//*                                                                     *//
+//*        All rights reserved. Subject to AMI licensing agreement.     *//
+//*                                                                     *//
+//***********************************************************************//
+#if CONFIG_INTEL_PFR_SUPPORT
+#include <stddef.h>
+#include <string.h>
+#include "state_machine/common_smc.h"
+#include "flash/flash_aspeed.h"
+#include "pfr/pfr_common.h"
+#include "pfr/pfr_util.h"
+#include "intel_pfr_definitions.h"
+#include "intel_pfr_pfm_manifest.h"
+#include "intel_pfr_measurement_cache.h"
+
+#undef DEBUG_PRINTF
+#if INTEL_MANIFEST_DEBUG
+#define DEBUG_PRINTF printk
+#else
+#define DEBUG_PRINTF(...)
+#endif
+
+/*
+ * Active region measurement cache.
+ *
+ * After a full verification of the active region passes, the digests of every write protected
+ * SPI region are sealed to the RoT internal state partition together with the hash of the PFM
+ * they were checked against.  The SPI filter blocks writes to these regions from T0 onwards and
+ * every RoT side write to the active region (update, recovery, decommission) invalidates the
+ * cache, so on the next boot a region is only re-hashed when it is writable, when the PFM has
+ * changed, or when MEASUREMENT_CACHE_FULL_VERIFY_INTERVAL boots have passed since the last full
+ * verification.
+ *
+ * The sealed cache is only rewritten when its content changes.  Boots are counted in a tally
+ * behind it in the same sector, one byte programmed per boot, so the sector is erased once the
+ * tally fills up rather than on every boot.
+ */
+
+#define MEASUREMENT_TALLY_OFFSET	sizeof(MEASUREMENT_CACHE)
+#define MEASUREMENT_TALLY_CHUNK		64
+
+static MEASUREMENT_CACHE measurement_cache;
+static bool measurement_cache_hit;
+static uint32_t measurement_tally_next;
+static uint32_t measurement_tally_reuses;
+
+static uint32_t measurement_cache_address(uint32_t image_type)
+{
+	return MEASUREMENT_CACHE_ADDRESS + (image_type * MEASUREMENT_CACHE_SIZE);
+}
+
+static uint8_t measurement_cache_hash_length(PFM_SPI_DEFINITION *spi_definition)
+{
+	if (spi_definition->HashAlgorithmInfo.SHA256HashPresent == 1)
+		return SHA256_DIGEST_LENGTH;
+	else if (spi_definition->HashAlgorithmInfo.SHA384HashPresent == 1)
+		return SHA384_DIGEST_LENGTH;
+
+	return 0;
+}
+
+static int measurement_cache_seal_digest(struct pfr_manifest *manifest, uint8_t *digest)
+{
+	return manifest->hash->calculate_sha256(manifest->hash, (uint8_t *)&measurement_cache,
+		offsetof(MEASUREMENT_CACHE, Seal), digest, SHA256_DIGEST_LENGTH);
+}
+
+/**
+    Function to count the boots served from the cache since the last full verification
+
+    @Param  address     Cache sector on the RoT internal state partition
+
+    @retval int         Success or Failure
+**/
+static int measurement_tally_scan(uint32_t address)
+{
+	uint8_t tally[MEASUREMENT_TALLY_CHUNK];
+	uint32_t offset = MEASUREMENT_TALLY_OFFSET;
+	uint32_t size;
+	uint32_t i;
+
+	measurement_tally_reuses = 0;
+
+	while (offset < MEASUREMENT_CACHE_SIZE) {
+		size = ((MEASUREMENT_CACHE_SIZE - offset) < sizeof(tally)) ? (MEASUREMENT_CACHE_SIZE - offset) : sizeof(tally);
+		if (pfr_spi_read(ROT_INTERNAL_STATE, address + offset, size, tally) != Success)
+			return Failure;
+
+		for (i = 0; i < size; i++, offset++) {
+			if (tally[i] == MEASUREMENT_TALLY_ERASED) {
+				measurement_tally_next = offset;
+				return Success;
+			}
+
+			if (tally[i] == MEASUREMENT_TALLY_FULL_VERIFY)
+				measurement_tally_reuses = 0;
+			else
+				measurement_tally_reuses++;
+		}
+	}
+
+	measurement_tally_next = MEASUREMENT_CACHE_SIZE;
+	return Success;
+}
+
+static int measurement_tally_append(uint32_t address, uint8_t mark)
+{
+	if (measurement_tally_next < MEASUREMENT_TALLY_OFFSET || measurement_tally_next >= MEASUREMENT_CACHE_SIZE)
+		return Failure;
+
+	return pfr_spi_write(ROT_INTERNAL_STATE, address + measurement_tally_next++, sizeof(mark), &mark);
+}
+
+/**
+    Function to check whether the sector already holds the cache as it is in RAM
+
+    @Param  address     Cache sector on the RoT internal state partition
+
+    @retval bool        true if the sealed cache in flash matches
+**/
+static bool measurement_cache_stored(uint32_t address)
+{
+	uint8_t stored[MEASUREMENT_TALLY_CHUNK];
+	uint32_t offset;
+	uint32_t size;
+
+	for (offset = 0; offset < sizeof(measurement_cache); offset += size) {
+		size = ((sizeof(measurement_cache) - offset) < sizeof(stored)) ? (sizeof(measurement_cache) - offset) : sizeof(stored);
+		if (pfr_spi_read(ROT_INTERNAL_STATE, address + offset, size, stored) != Success ||
+		    memcmp(stored, (uint8_t *)&measurement_cache + offset, size))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+    Function to hash the signed PFM (Block0/Block1 and PFM body) at manifest->address
+
+    @Param  manifest    PFR manifest with address pointing to the PFM signature block
+    @Param  pfm_hash    Output buffer, SHA256_DIGEST_LENGTH bytes
+
+    @retval int         Success or Failure
+**/
+static int measurement_cache_pfm_hash(struct pfr_manifest *manifest, uint8_t *pfm_hash)
+{
+	int status = 0;
+	PFM_STRUCTURE_1 pfm_data;
+
+	status = pfr_spi_read(manifest->image_type, manifest->address + PFM_SIG_BLOCK_SIZE, sizeof(PFM_STRUCTURE_1), (uint8_t *)&pfm_data);
+	if (status != Success || pfm_data.PfmTag != PFMTAG)
+		return Failure;
+
+	manifest->pfr_hash->start_address = manifest->address;
+	manifest->pfr_hash->length = PFM_SIG_BLOCK_SIZE + pfm_data.Length;
+	manifest->pfr_hash->type = HASH_TYPE_SHA256;
+
+	return get_hash((struct manifest *)manifest, manifest->hash, pfm_hash, SHA256_DIGEST_LENGTH);
+}
+
+/**
+    Function to load the sealed measurement cache for the active PFM at manifest->address
+
+    @Param  manifest    PFR manifest of the active region being verified
+
+    @retval int         Success if regions can be recorded for this PFM, Failure otherwise
+**/
+int measurement_cache_open(struct pfr_manifest *manifest)
+{
+	int status = 0;
+	uint8_t pfm_hash[SHA256_DIGEST_LENGTH];
+	uint8_t seal[SHA256_DIGEST_LENGTH];
+
+	measurement_cache_hit = false;
+	memset(&measurement_cache, 0, sizeof(measurement_cache));
+
+	status = measurement_cache_pfm_hash(manifest, pfm_hash);
+	if (status != Success)
+		return Failure;
+
+	status = pfr_spi_read(ROT_INTERNAL_STATE, measurement_cache_address(manifest->image_type), sizeof(measurement_cache), (uint8_t *)&measurement_cache);
+	if (status == Success &&
+	    measurement_cache.Magic == MEASUREMENT_CACHE_MAGIC &&
+	    measurement_cache.Version == MEASUREMENT_CACHE_VERSION &&
+	    measurement_cache.RegionCount <= MEASUREMENT_CACHE_MAX_REGIONS &&
+	    measurement_cache.PfmAddress == manifest->address &&
+	    measurement_cache_seal_digest(manifest, seal) == Success &&
+	    compare_buffer(seal, measurement_cache.Seal, SHA256_DIGEST_LENGTH) == Success &&
+	    compare_buffer(pfm_hash, measurement_cache.PfmHash, SHA256_DIGEST_LENGTH) == Success &&
+	    measurement_tally_scan(measurement_cache_address(manifest->image_type)) == Success) {
+		if (measurement_tally_reuses < MEASUREMENT_CACHE_FULL_VERIFY_INTERVAL) {
+			measurement_cache_hit = true;
+			DEBUG_PRINTF("Measurement cache hit, %d regions\r\n", measurement_cache.RegionCount);
+			return Success;
+		}
+		DEBUG_PRINTF("Measurement cache expired, full verification\r\n");
+	}
+
+	// Start a fresh cache, sealed once the full verification passes
+	memset(&measurement_cache, 0, sizeof(measurement_cache));
+	measurement_cache.Magic = MEASUREMENT_CACHE_MAGIC;
+	measurement_cache.Version = MEASUREMENT_CACHE_VERSION;
+	measurement_cache.PfmAddress = manifest->address;
+	memcpy(measurement_cache.PfmHash, pfm_hash, SHA256_DIGEST_LENGTH);
+
+	return Success;
+}
+
+/**
+    Function to check whether a region is unchanged since the cache was sealed
+
+    @Param  spi_definition  PFM SPI region definition
+    @Param  digest          Expected region digest from the PFM
+
+    @retval bool            true if the region can skip re-hashing
+**/
+bool measurement_cache_lookup(PFM_SPI_DEFINITION *spi_definition, uint8_t *digest)
+{
+	uint8_t hash_length = measurement_cache_hash_length(spi_definition);
+	MEASURED_REGION *region;
+	int i;
+
+	// Writable regions can change at runtime and are always re-hashed
+	if (!measurement_cache_hit || spi_definition->ProtectLevelMask.WriteAllowed || !hash_length)
+		return false;
+
+	for (i = 0; i < measurement_cache.RegionCount; i++) {
+		region = &measurement_cache.Region[i];
+		if (region->StartAddress == spi_definition->RegionStartAddress &&
+		    region->EndAddress == spi_definition->RegionEndAddress &&
+		    region->HashLength == hash_length &&
+		    compare_buffer(region->Digest, digest, hash_length) == Success)
+			return true;
+	}
+
+	return false;
+}
+
+/**
+    Function to record a region that passed hash verification
+
+    @Param  spi_definition  PFM SPI region definition
+    @Param  digest          Verified region digest
+**/
+void measurement_cache_record(PFM_SPI_DEFINITION *spi_definition, uint8_t *digest)
+{
+	uint8_t hash_length = measurement_cache_hash_length(spi_definition);
+	MEASURED_REGION *region;
+
+	if (measurement_cache_hit || measurement_cache.Magic != MEASUREMENT_CACHE_MAGIC)
+		return;
+
+	if (spi_definition->ProtectLevelMask.WriteAllowed || !hash_length ||
+	    measurement_cache.RegionCount >= MEASUREMENT_CACHE_MAX_REGIONS)
+		return;
+
+	region = &measurement_cache.Region[measurement_cache.RegionCount++];
+	region->StartAddress = spi_definition->RegionStartAddress;
+	region->EndAddress = spi_definition->RegionEndAddress;
+	region->HashLength = hash_length;
+	memcpy(region->Digest, digest, hash_length);
+}
+
+/**
+    Function to seal the measurement cache after the active region passed verification
+
+    @Param  manifest    PFR manifest of the verified active region
+
+    @retval int         Success or Failure
+**/
+int measurement_cache_seal(struct pfr_manifest *manifest)
+{
+	int status = 0;
+	uint32_t address = measurement_cache_address(manifest->image_type);
+
+	if (measurement_cache.Magic != MEASUREMENT_CACHE_MAGIC || !MEASUREMENT_CACHE_FULL_VERIFY_INTERVAL)
+		return Failure;
+
+	if (measurement_cache_hit) {
+		if (measurement_tally_append(address, MEASUREMENT_TALLY_REUSE) == Success)
+			return Success;
+
+		// Tally is full, fall back to a full verification on the next boot
+		measurement_cache_hit = false;
+		return pfr_spi_erase_4k(ROT_INTERNAL_STATE, address);
+	}
+
+	status = measurement_cache_seal_digest(manifest, measurement_cache.Seal);
+	if (status != Success)
+		return Failure;
+
+	// Same measurements as sealed before, only restart the boot count
+	if (measurement_cache_stored(address) &&
+	    measurement_tally_scan(address) == Success &&
+	    measurement_tally_append(address, MEASUREMENT_TALLY_FULL_VERIFY) == Success)
+		return Success;
+
+	status = pfr_spi_erase_4k(ROT_INTERNAL_STATE, address);
+	if (status != Success)
+		return Failure;
+
+	measurement_tally_next = MEASUREMENT_TALLY_OFFSET;
+	return pfr_spi_write(ROT_INTERNAL_STATE, address, sizeof(measurement_cache), (uint8_t *)&measurement_cache);
+}
+
+/**
+    Function to drop the sealed measurements before the RoT writes to an active region
+
+    @Param  image_type  BMC_TYPE or PCH_TYPE
+
+    @retval int         Success or Failure
+**/
+int measurement_cache_invalidate(uint32_t image_type)
+{
+	if (image_type != BMC_TYPE && image_type != PCH_TYPE)
+		return Failure;
+
+	measurement_cache_hit = false;
+	return pfr_spi_erase_4k(ROT_INTERNAL_STATE, measurement_cache_address(image_type));
+}
+
+#endif
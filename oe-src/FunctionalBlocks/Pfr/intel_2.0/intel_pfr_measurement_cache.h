@@ -0,0 +1,56 @@
+//***********************************************************************//
+//*                                                                     *//
+//*                      Copyright © 2022 AMI                           *//
+//*                                                                     *//
+//*        All rights reserved. Subject to AMI licensing agreement.     *//
+//*                                                                     *//
+//***********************************************************************//
+
+#ifndef INTEL_PFR_MEASUREMENT_CACHE_H_
+#define INTEL_PFR_MEASUREMENT_CACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pfr/pfr_common.h"
+#include "intel_pfr_definitions.h"
+#include "intel_pfr_pfm_manifest.h"
+
+#define MEASUREMENT_CACHE_MAGIC		0x4D434348	// "MCCH"
+#define MEASUREMENT_CACHE_VERSION	2
+#define MEASUREMENT_CACHE_MAX_REGIONS	32
+
+// Boot tally, one byte per boot appended after the sealed cache
+#define MEASUREMENT_TALLY_ERASED	0xFF
+#define MEASUREMENT_TALLY_REUSE		0x00	// Boot served from the cache
+#define MEASUREMENT_TALLY_FULL_VERIFY	0x5A	// Full verification matched the sealed cache
+
+#pragma pack(1)
+
+typedef struct _MEASURED_REGION {
+	uint32_t StartAddress;
+	uint32_t EndAddress;
+	uint8_t  HashLength;
+	uint8_t  Reserved[3];
+	uint8_t  Digest[SHA384_DIGEST_LENGTH];
+} MEASURED_REGION;
+
+typedef struct _MEASUREMENT_CACHE {
+	uint32_t Magic;
+	uint8_t  Version;
+	uint8_t  RegionCount;
+	uint8_t  Reserved[2];
+	uint32_t PfmAddress;
+	uint8_t  PfmHash[SHA256_DIGEST_LENGTH];		// Block0/Block1 and PFM body the regions were measured against
+	MEASURED_REGION Region[MEASUREMENT_CACHE_MAX_REGIONS];
+	uint8_t  Seal[SHA256_DIGEST_LENGTH];		// SHA256 over everything above
+} MEASUREMENT_CACHE;
+
+#pragma pack()
+
+int measurement_cache_open(struct pfr_manifest *manifest);
+bool measurement_cache_lookup(PFM_SPI_DEFINITION *spi_definition, uint8_t *digest);
+void measurement_cache_record(PFM_SPI_DEFINITION *spi_definition, uint8_t *digest);
+int measurement_cache_seal(struct pfr_manifest *manifest);
+int measurement_cache_invalidate(uint32_t image_type);
+
+#endif /*INTEL_PFR_MEASUREMENT_CACHE_H_*/
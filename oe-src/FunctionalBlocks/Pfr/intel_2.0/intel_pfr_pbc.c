@@ -7,8 +7,11 @@
 //***********************************************************************//
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "state_machine/common_smc.h"
 #include "intel_pfr_definitions.h"
+#include "intel_pfr_measurement_cache.h"
+#include "intel_pfr_update_checkpoint.h"
 
 
 #if PF_UPDATE_DEBUG
@@ -58,10 +61,11 @@ int is_compression_tag_matched(uint32_t image_type, uint32_t *compression_tag,ui
 
     @Param uint32_t		Size
 	@Param uint32_t    	Active Bit Map Address
+	@Param uint32_t    	First page to erase, non zero when resuming from a checkpoint
 
     @retval int		Return Status
 **/
-int decompression_erasing(uint32_t image_type, uint32_t N,uint32_t active_map_address)
+int decompression_erasing(uint32_t image_type, uint32_t N,uint32_t active_map_address, uint32_t start_page)
 {
 	int status = 0;
     uint32_t index0 = 0;
@@ -71,7 +75,10 @@ int decompression_erasing(uint32_t image_type, uint32_t N,uint32_t active_map_ad
 	
     // Loop To Erase the data in destination chip based on the Active Buffer data
     DEBUG_PRINTF("Erasing...\r\n");
-    for (index0 = 0; index0 < N/8; index0++)
+    index0 = start_page / 8;
+    active_map_address += index0;
+    erase_offset = index0 * 8 * PAGE_SIZE;
+    for (; index0 < N/8; index0++)
     {
         status = pfr_spi_read(image_type, active_map_address, sizeof(uint8_t), (uint8_t *)&bit_map_data);
         if(status != Success){
@@ -92,6 +99,9 @@ int decompression_erasing(uint32_t image_type, uint32_t N,uint32_t active_map_ad
             }
             erase_offset += PAGE_SIZE;
         }
+#if UPDATE_CHECKPOINT_SUPPORT
+        update_checkpoint_progress(CHECKPOINT_PHASE_ERASE, (index0 + 1) * 8);
+#endif
     }
     DEBUG_PRINTF("Erase Successful\r\n");
     return Success;
@@ -104,16 +114,19 @@ int decompression_erasing(uint32_t image_type, uint32_t N,uint32_t active_map_ad
     @Param uint32_t     	Size
     @Param uint32_t     	Compression Tag
     @Param uint32_t     	Compression Map Address
+    @Param uint32_t     	First page to write, non zero when resuming from a checkpoint
+    @Param bool     		Resuming, pages right after start_page may be partially programmed
 
     @retval int			Return Status
 **/
-int decompression_write(uint32_t image_type, uint32_t N,uint32_t compression_tag,uint32_t compression_map_address)
+int decompression_write(uint32_t image_type, uint32_t N,uint32_t compression_tag,uint32_t compression_map_address, uint32_t start_page, bool resume)
 {
 	int status = 0;
     uint8_t bit_map_data = 0;
 	uint32_t index0 = 0;
 	int8_t index1 = 0;
 	uint32_t erase_offset = 0;
+	uint32_t page = 0;
 	
     //Loop to Write the Data in destination Chip Based on the Compression Buffer data
     DEBUG_PRINTF("Writing...\r\n");
@@ -127,14 +140,31 @@ int decompression_write(uint32_t image_type, uint32_t N,uint32_t compression_tag
         for (index1 = 7; index1 >= 0; index1--)
         {
 			if ((bit_map_data >> index1) & 1){
-			    status = pfr_spi_page_read_write(image_type, &compression_tag,&erase_offset);
-			    if(status != Success)
-			    	return Failure;
+				if (page < start_page) {
+					// Written before the reset
+					compression_tag += PAGE_SIZE;
+					erase_offset += PAGE_SIZE;
+				} else {
+#if UPDATE_CHECKPOINT_SUPPORT
+					if (resume && page < start_page + (UPDATE_CHECKPOINT_INTERVAL / PAGE_SIZE)) {
+						status = pfr_spi_erase_4k(image_type, erase_offset);
+						if(status != Success)
+							return Failure;
+					}
+#endif
+					status = pfr_spi_page_read_write(image_type, &compression_tag,&erase_offset);
+					if(status != Success)
+						return Failure;
+				}
 			}
 			else {
 				erase_offset += PAGE_SIZE;
 			}
+			page++;
         }
+#if UPDATE_CHECKPOINT_SUPPORT
+        update_checkpoint_progress(CHECKPOINT_PHASE_WRITE, page);
+#endif
     }
     return Success;
 }
@@ -153,6 +183,8 @@ int capsule_decompression(uint32_t image_type, uint32_t read_address,uint32_t ar
     uint32_t compression_tag = read_address;
     uint32_t N = 0;
     uint32_t bit_map_address = 0;
+    uint32_t phase = 0;
+    uint32_t start_page = 0;
     
     if(is_compression_tag_matched(image_type, &compression_tag, read_address,area_size))
     {
@@ -160,6 +192,11 @@ int capsule_decompression(uint32_t image_type, uint32_t read_address,uint32_t ar
         return Failure;
     }
 
+#if MEASUREMENT_CACHE_SUPPORT
+    // Active region is about to be rewritten, drop its sealed measurements
+    measurement_cache_invalidate(image_type);
+#endif
+
     // Collecting the Active and Compression Buffer Values.
     compression_tag += 20;
     status = pfr_spi_read(image_type, compression_tag, sizeof(uint32_t), (uint8_t *)&N);
@@ -171,20 +208,36 @@ int capsule_decompression(uint32_t image_type, uint32_t read_address,uint32_t ar
     compression_tag += 108;
     bit_map_address = compression_tag;
 
-    status = decompression_erasing(image_type, N,bit_map_address);
-    if(status != Success){
-		return Failure;
-	}
+#if UPDATE_CHECKPOINT_SUPPORT
+    // Pick up where an interrupted decompression of the same capsule left off
+    update_checkpoint_open(CHECKPOINT_OP_DECOMPRESSION, image_type, read_address, area_size, &phase, &start_page);
+#endif
+
+    if (phase != CHECKPOINT_PHASE_WRITE) {
+        status = decompression_erasing(image_type, N,bit_map_address, start_page);
+        if(status != Success){
+            return Failure;
+        }
+        start_page = 0;
+    }
 
     compression_tag += N/8;
     bit_map_address = compression_tag;
     compression_tag += N/8;
 
-	status = decompression_write(image_type, N,compression_tag,bit_map_address);
+#if UPDATE_CHECKPOINT_SUPPORT
+    update_checkpoint_progress(CHECKPOINT_PHASE_WRITE, 0);
+#endif
+
+	status = decompression_write(image_type, N,compression_tag,bit_map_address, start_page, phase == CHECKPOINT_PHASE_WRITE);
 	if(status != Success){
 		DEBUG_PRINTF("Decompression write failed\r\n");
 		return Failure;
 	}
+
+#if UPDATE_CHECKPOINT_SUPPORT
+    update_checkpoint_close();
+#endif
     DEBUG_PRINTF("Decompression completed\r\n");
     return Success;
 }
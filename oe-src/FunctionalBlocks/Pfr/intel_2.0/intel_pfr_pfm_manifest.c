@@ -11,6 +11,8 @@
 #include "state_machine/common_smc.h"
 #include "intel_pfr_provision.h"
 #include "pfr/pfr_common.h"
+#include "pfr/pfr_util.h"
+#include "intel_pfr_measurement_cache.h"
 
 #undef DEBUG_PRINTF
 #if INTEL_MANIFEST_DEBUG
@@ -160,10 +162,18 @@ int spi_region_hash_verification(struct pfr_manifest *pfr_manifest, PFM_SPI_DEFI
             PfmSpiDefinition->RegionStartAddress, PfmSpiDefinition->RegionEndAddress);
     region_length =(PfmSpiDefinition->RegionEndAddress) - (PfmSpiDefinition->RegionStartAddress);
 
+#if MEASUREMENT_CACHE_SUPPORT
+    if (measurement_cache_lookup(PfmSpiDefinition, pfm_spi_Hash)) {
+        DEBUG_PRINTF("Region unchanged since last boot, hash skipped\r\n");
+        return Success;
+    }
+#endif
+
     if((PfmSpiDefinition->HashAlgorithmInfo.SHA256HashPresent == 1 ) ||
             (PfmSpiDefinition->HashAlgorithmInfo.SHA384HashPresent == 1)){
     	
 		uint8_t sha256_buffer[SHA384_DIGEST_LENGTH] = {0};
+		struct pfr_hash_region region;
 		uint32_t hash_length = 0;		
 
 		pfr_manifest->pfr_hash->start_address = PfmSpiDefinition->RegionStartAddress;
@@ -179,13 +189,21 @@ int spi_region_hash_verification(struct pfr_manifest *pfr_manifest, PFM_SPI_DEFI
 			return Failure;
 		}
 
-		pfr_manifest->base->get_hash(pfr_manifest,pfr_manifest->hash,sha256_buffer, SHA256_DIGEST_LENGTH);
-			
-		status = compare_buffer(pfm_spi_Hash, sha256_buffer,SHA256_DIGEST_LENGTH);
+		region.start_address = PfmSpiDefinition->RegionStartAddress;
+		region.length = region_length;
+		status = pfr_spi_hash_regions(pfr_manifest->flash->device_id[0], &region, 1,
+				pfr_manifest->pfr_hash->type, sha256_buffer, hash_length);
+		if (status != Success)
+			return Failure;
+
+		status = compare_buffer(pfm_spi_Hash, sha256_buffer, hash_length);
         if(status != Success){
 			return Failure;
 			
 		}		
+#if MEASUREMENT_CACHE_SUPPORT
+		measurement_cache_record(PfmSpiDefinition, pfm_spi_Hash);
+#endif
     }
 	
 	DEBUG_PRINTF("Digest verification success\r\n");
@@ -385,6 +403,10 @@ int pfm_spi_region_verification(struct pfr_manifest *manifest)
 	uint8_t fvm_region_count = 0;
     
 	region_count = 0;
+
+#if MEASUREMENT_CACHE_SUPPORT
+    measurement_cache_open(manifest);
+#endif
     
     for (position = 0; position <= g_pfm_manifest_length - 1; region_count++){
     	verify_status = get_pfm_manifest_data(manifest, &position, (void *)&pfm_spi_definition, (uint8_t *)&pfm_spi_hash, pfm_definition_type);
@@ -416,6 +438,10 @@ int pfm_spi_region_verification(struct pfr_manifest *manifest)
         bmc_protect_level_mask_count.Calculated = 1;
     }
 
+#if MEASUREMENT_CACHE_SUPPORT
+    measurement_cache_seal(manifest);
+#endif
+
     return Success;
 }
 
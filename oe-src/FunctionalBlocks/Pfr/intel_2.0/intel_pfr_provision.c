@@ -7,12 +7,14 @@
 //***********************************************************************//
 
 #include <stdint.h>
+#include <string.h>
 #include "state_machine/common_smc.h"
 #include "pfr/pfr_common.h"
 #include "intel_pfr_definitions.h"
 #include "pfr/pfr_util.h"
 #include "intel_pfr_provision.h" 
 #include "intel_pfr_verification.h" 
+#include "Smbus_mailbox/Smbus_mailbox.h"
 
 #undef DEBUG_PRINTF
 #if PFR_AUTHENTICATION_DEBUG
@@ -23,6 +25,40 @@
 
 int g_provision_data;
 
+/*
+ * Root key accepted this boot.  Every Block1 (active PFM, recovery and staging capsules, FVMs,
+ * BMC and PCH) carries the same root key, so once it has matched the provisioned root key hash
+ * later root entries are compared against this copy instead of being hashed again.  The record
+ * is tied to the provisioning generation and is dropped as soon as provisioning changes.
+ */
+static uint8_t verified_root_key[2 * SHA384_DIGEST_LENGTH];
+static uint8_t verified_root_key_length;
+static uint32_t verified_root_key_generation;
+
+static bool root_key_verified(uint8_t *pubkey_x, uint8_t *pubkey_y, uint8_t digest_length)
+{
+	int status;
+
+	if (verified_root_key_length != (2 * digest_length) ||
+	    verified_root_key_generation != provision_shadow_generation())
+		return false;
+
+	// compare_buffer always walks the full length
+	status = compare_buffer(verified_root_key, pubkey_x, digest_length);
+	if (compare_buffer(&verified_root_key[digest_length], pubkey_y, digest_length) != Success)
+		status = Failure;
+
+	return status == Success;
+}
+
+static void root_key_record(uint8_t *pubkey_x, uint8_t *pubkey_y, uint8_t digest_length)
+{
+	memcpy(verified_root_key, pubkey_x, digest_length);
+	memcpy(&verified_root_key[digest_length], pubkey_y, digest_length);
+	verified_root_key_length = 2 * digest_length;
+	verified_root_key_generation = provision_shadow_generation();
+}
+
 //Verify Root Key hash
 int verify_root_key_hash(struct pfr_manifest *manifest, uint8_t *root_public_key)
 {
@@ -74,6 +110,9 @@ int verify_root_key_data(struct pfr_manifest *manifest, uint8_t *pubkey_x, uint8
         return Failure;
     }
 
+	if (root_key_verified(pubkey_x, pubkey_y, digest_length))
+		return Success;
+
     // Root Public Key update
 	memcpy(&root_public_key[0], pubkey_x,digest_length);
 	memcpy(&root_public_key[digest_length], pubkey_y, digest_length);
@@ -92,6 +131,8 @@ int verify_root_key_data(struct pfr_manifest *manifest, uint8_t *pubkey_x, uint8
     if(status != Success)
         return Failure;
 
+	root_key_record(pubkey_x, pubkey_y, digest_length);
+
 	return Success;
 }
 
@@ -15,6 +15,10 @@
 #include "intel_pfr_verification.h"
 #include "CommonFlash/CommonFlash.h"
 #include "flash/flash_util.h"
+#include "pfr/pfr_util.h"
+#include "intel_pfr_update.h"
+#include "intel_pfr_update_checkpoint.h"
+#include "intel_pfr_capsule_verdict.h"
 
 #if PF_UPDATE_DEBUG
 #define DEBUG_PRINTF printk
@@ -64,17 +68,19 @@ int pfr_recover_recovery_region(int image_type,uint32_t source_address,uint32_t
 {   
     int status = 0;
     uint32_t area_size = 0;
-    struct SpiEngine *spi_flash = getSpiEngineWrapper();
 
     if(image_type == BMC_TYPE)
     	area_size = BMC_STAGING_SIZE;
     if(image_type == PCH_TYPE)
         area_size = PCH_STAGING_SIZE;
 
-    spi_flash->spi.device_id[0] = image_type; // assign the flash device id,  0:spi1_cs0, 1:spi2_cs0 , 2:spi2_cs1, 3:spi2_cs2, 4:fmc_cs0, 5:fmc_cs1
     DEBUG_PRINTF("Recovering...");
 
-	status = flash_copy_and_verify(&spi_flash->spi, target_address, source_address, area_size);
+#if CAPSULE_VERDICT_SUPPORT
+    capsule_verdict_invalidate(image_type);
+#endif
+
+	status = pfr_spi_copy_and_verify(image_type, source_address, image_type, target_address, area_size);
 	if(status != Success){
         DEBUG_PRINTF("Recovery region update failed\r\n");  
         return Failure;
@@ -85,6 +91,62 @@ int pfr_recover_recovery_region(int image_type,uint32_t source_address,uint32_t
     return Success;
 }
 
+#if UPDATE_CHECKPOINT_SUPPORT
+/**
+    Function to finish an active region update that was interrupted by a reset.  The staging
+    capsule must be the one the update was decompressing from, and it has to pass the same
+    checks as a new active update: authentication, a good recovery region and anti-rollback.
+
+    @Param  manifest    PFR manifest of the corrupted active region
+
+    @retval int         Success if the update was completed, Failure to fall back to recovery
+**/
+static int pfr_resume_active_update(struct pfr_manifest *manifest)
+{
+    int status = 0;
+    uint32_t staging_address = 0;
+    uint32_t area_size;
+    uint8_t active_svn_number;
+
+    status = ufm_read(PROVISION_UFM, manifest->image_type == BMC_TYPE ? BMC_STAGING_REGION_OFFSET : PCH_STAGING_REGION_OFFSET,
+        (uint8_t *)&staging_address, sizeof(staging_address));
+    if (status != Success)
+        return Failure;
+
+    if (update_checkpoint_pending(CHECKPOINT_OP_DECOMPRESSION, manifest->image_type, staging_address) != Success)
+        return Failure;
+
+    manifest->state = UPDATE;
+
+    status = intel_pfr_recovery_verify((struct recovery_image *)manifest, manifest->hash, manifest->verification->base,
+        manifest->pfr_hash->hash_out, manifest->pfr_hash->length, manifest->recovery_pfm);
+    if (status != Success)
+        goto done;
+
+    manifest->address = staging_address;
+    status = intel_pfr_update_verify((struct firmware_image *)manifest, NULL, NULL);
+    if (status != Success)
+        goto done;
+
+    active_svn_number = get_ufm_svn(manifest, manifest->image_type == BMC_TYPE ? SVN_POLICY_FOR_BMC_FW_UPDATE : SVN_POLICY_FOR_PCH_FW_UPDATE);
+    status = check_svn_number(manifest, staging_address, active_svn_number);
+    if (status != Success) {
+        DEBUG_PRINTF("Anti rollback\r\n");
+        goto done;
+    }
+
+    DEBUG_PRINTF("Resuming interrupted active update\r\n");
+    area_size = manifest->update_fw->pc_length - (PFM_SIG_BLOCK_SIZE + manifest->update_fw->pfm_length);
+    status = capsule_decompression(manifest->image_type, staging_address, area_size);
+    if (status == Success)
+        status = active_region_pfm_update(manifest);
+
+done:
+    manifest->state = RECOVERY;
+    return status;
+}
+#endif
+
 int pfr_recover_active_region(struct pfr_manifest *manifest){
 
     int status  = 0;
@@ -93,6 +155,13 @@ int pfr_recover_active_region(struct pfr_manifest *manifest){
     uint32_t area_size;
     
     DEBUG_PRINTF("Active Data Corrupted\r\n");
+
+#if UPDATE_CHECKPOINT_SUPPORT
+    if (pfr_resume_active_update(manifest) == Success) {
+        DEBUG_PRINTF("Repair success\r\n");
+        return Success;
+    }
+#endif
     if(manifest->image_type == BMC_TYPE){
         status = ufm_read(PROVISION_UFM,BMC_RECOVERY_REGION_OFFSET,(uint8_t*)&read_address,sizeof(read_address));
         if (status != Success)
@@ -162,11 +231,8 @@ int active_region_pfm_update(struct pfr_manifest *manifest) {
 	//Adjusting capsule offset size to PFM Signing chain
 	capsule_offset += PFM_SIG_BLOCK_SIZE;
 	
-    struct SpiEngine *spi_flash = getSpiEngineWrapper();
-    spi_flash->spi.device_id[0] = manifest->image_type; // assign the flash device id,  0:spi1_cs0, 1:spi2_cs0 , 2:spi2_cs1, 3:spi2_cs2, 4:fmc_cs0, 5:fmc_cs1
-    
     //Updating PFM from capsule to active region
-	status = flash_copy_and_verify(&spi_flash->spi, active_offset, capsule_offset, PAGE_SIZE);
+	status = pfr_spi_copy_and_verify(manifest->image_type, capsule_offset, manifest->image_type, active_offset, PAGE_SIZE);
 	if(status != Success){
         return Failure;
     }
@@ -206,7 +272,7 @@ int pfr_staging_pch_staging(struct pfr_manifest *manifest){
 
     DEBUG_PRINTF("BMC(PCH) Staging Area verification\r\n");
     //manifest verifcation
-    status = manifest->base->verify(manifest,manifest->hash,manifest->verification->base, manifest->pfr_hash->hash_out, manifest->pfr_hash->length);
+    status = intel_pfr_manifest_verify((struct manifest *)manifest, manifest->hash,manifest->verification->base, manifest->pfr_hash->hash_out, manifest->pfr_hash->length);
     if(status != Success){
         DEBUG_PRINTF("verify failed\r\n");
         return Failure;
@@ -216,7 +282,7 @@ int pfr_staging_pch_staging(struct pfr_manifest *manifest){
     manifest->address += PFM_SIG_BLOCK_SIZE;
     manifest->pc_type = PFR_PCH_PFM;
     //manifest verifcation
-    status = manifest->base->verify(manifest,manifest->hash,manifest->verification->base, manifest->pfr_hash->hash_out, manifest->pfr_hash->length);
+    status = intel_pfr_manifest_verify((struct manifest *)manifest, manifest->hash,manifest->verification->base, manifest->pfr_hash->hash_out, manifest->pfr_hash->length);
     if(status != Success){
         return Failure;
     }
@@ -224,27 +290,13 @@ int pfr_staging_pch_staging(struct pfr_manifest *manifest){
     manifest->address = target_address;
     manifest->image_type = image_type;
 
-	uint32_t erase_address = target_address;
-
-	for (int i = 0; i < (area_size / PAGE_SIZE); i++) {
-
-		status = pfr_spi_erase_4k(manifest->image_type, erase_address);
-		if(status != Success){
-			return Failure;
-		}
-
-		erase_address += PAGE_SIZE;
-	}
-
-	for(int i = 0; i < (area_size / PAGE_SIZE); i++){
-        status = pfr_spi_page_read_write_between_spi(BMC_TYPE, &source_address,PCH_TYPE, &target_address);
-		if (status != Success)
-			return Failure;
-	}
+	status = pfr_spi_copy_and_verify(BMC_TYPE, source_address, PCH_TYPE, target_address, area_size);
+	if (status != Success)
+		return Failure;
 
 	if (manifest->state == RECOVERY) {
         DEBUG_PRINTF("PCH staging region verification\r\n");
-        status = manifest->update_fw->base->verify(manifest, NULL, NULL);
+        status = intel_pfr_update_verify((struct firmware_image *)manifest, NULL, NULL);
         if(status != Success)
             return Failure;
 	}
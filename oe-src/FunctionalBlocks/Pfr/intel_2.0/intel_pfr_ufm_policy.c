@@ -0,0 +1,79 @@
+//***********************************************************************//
+//*                                                                     *//
+//*                      Copyright © 2022 AMI                           *//
+//*                                                                     *//
+//*        All rights reserved. Subject to AMI licensing agreement.     *//
+//*                                                                     *//
+//***********************************************************************//
+#if CONFIG_INTEL_PFR_SUPPORT
+#include <string.h>
+#include "state_machine/common_smc.h"
+#include "pfr/pfr_common.h"
+#include "Smbus_mailbox/Smbus_mailbox.h"
+#include "intel_pfr_definitions.h"
+#include "intel_pfr_provision.h"
+#include "intel_pfr_ufm_policy.h"
+
+/*
+ * SVN and key cancellation policy lookups.
+ *
+ * The policies are served from the provisioning UFM shadow kept by the mailbox, which is loaded
+ * with a single UFM read and refreshed by every provisioning write, so SVN and CSK checks never
+ * have to go back to the internal flash.
+ */
+
+static uint8_t *ufm_policy_get(uint32_t offset, uint32_t length)
+{
+	if (offset < UFM_POLICY_START || (offset + length) > UFM_POLICY_END)
+		return NULL;
+
+	return provision_shadow_get(offset, length);
+}
+
+/**
+    Function to get the SVN of a SVN policy
+
+    The policy is a 64 bit thermometer code cleared from bit 0 of the first byte upwards, so
+    the SVN is the number of trailing zero bits of the little endian word.
+
+    @Param  offset  SVN policy offset
+    @Param  svn     Output SVN (0 - 64)
+
+    @retval int     Success or Failure
+**/
+int ufm_policy_get_svn(uint32_t offset, uint8_t *svn)
+{
+	uint8_t *policy = ufm_policy_get(offset, UFM_SVN_POLICY_SIZE);
+	uint64_t svn_policy;
+
+	if (policy == NULL)
+		return Failure;
+
+	memcpy(&svn_policy, policy, sizeof(svn_policy));
+	*svn = svn_policy ? __builtin_ctzll(svn_policy) : 64;
+
+	return Success;
+}
+
+/**
+    Function to check a CSK key id against a key cancellation policy
+
+    @Param  offset      Key cancellation policy offset
+    @Param  key_id      CSK key id
+    @Param  cancelled   Output, true if the key id was cancelled
+
+    @retval int         Success or Failure
+**/
+int ufm_policy_key_cancelled(uint32_t offset, uint32_t key_id, bool *cancelled)
+{
+	uint8_t *policy = ufm_policy_get(offset, CSK_KEY_SIZE);
+
+	if (policy == NULL || (key_id / 8) > (CSK_KEY_SIZE - 1))
+		return Failure;
+
+	*cancelled = !(policy[key_id / 8] & (0x80 >> (key_id % 8)));
+
+	return Success;
+}
+
+#endif
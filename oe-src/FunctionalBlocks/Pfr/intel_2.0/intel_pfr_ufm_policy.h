@@ -0,0 +1,25 @@
+//***********************************************************************//
+//*                                                                     *//
+//*                      Copyright © 2022 AMI                           *//
+//*                                                                     *//
+//*        All rights reserved. Subject to AMI licensing agreement.     *//
+//*                                                                     *//
+//***********************************************************************//
+
+#ifndef INTEL_PFR_UFM_POLICY_H_
+#define INTEL_PFR_UFM_POLICY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "intel_pfr_definitions.h"
+#include "intel_pfr_provision.h"
+
+// SVN and key cancellation policies are contiguous in the provisioning UFM
+#define UFM_POLICY_START	SVN_POLICY_FOR_CPLD_UPDATE
+#define UFM_POLICY_END		(KEY_CANCELLATION_POLICY_FOR_SIGNING_CPLD_UPDATE_CAPSULE + CSK_KEY_SIZE)
+#define UFM_SVN_POLICY_SIZE	8
+
+int ufm_policy_get_svn(uint32_t offset, uint8_t *svn);
+int ufm_policy_key_cancelled(uint32_t offset, uint32_t key_id, bool *cancelled);
+
+#endif /*INTEL_PFR_UFM_POLICY_H_*/
@@ -6,6 +6,8 @@
 //*                                                                     *//
 //***********************************************************************//
 #if CONFIG_INTEL_PFR_SUPPORT
+#include <stddef.h>
+#include <storage/flash_map.h>
 #include "pfr/pfr_update.h"
 #include "StateMachineAction/StateMachineActions.h"
 #include "state_machine/common_smc.h" 
@@ -13,11 +15,18 @@
 #include "intel_pfr_definitions.h"
 #include "include/SmbusMailBoxCom.h"
 #include "intel_pfr_verification.h"
+#include "intel_pfr_recovery.h"
+#include "intel_pfr_update.h"
 #include "intel_pfr_provision.h" 
 #include "intel_pfr_definitions.h"
 #include "StateMachineAction/StateMachineActions.h"
 #include "intel_pfr_pfm_manifest.h"
+#include "intel_pfr_measurement_cache.h"
+#include "intel_pfr_capsule_verdict.h"
+#include "intel_pfr_ufm_policy.h"
 #include "flash/flash_aspeed.h"
+#include "pfr/pfr_util.h"
+#include "abr/abr_aspeed.h"
 
 #if PF_UPDATE_DEBUG
 #define DEBUG_PRINTF printk
@@ -65,7 +74,7 @@ int pfr_staging_verify(struct pfr_manifest *manifest){
     manifest->recovery_address = target_address;   
 
     //manifest verification
-    status = manifest->base->verify(manifest,manifest->hash,manifest->verification->base, manifest->pfr_hash->hash_out, manifest->pfr_hash->length);
+    status = intel_pfr_manifest_verify((struct manifest *)manifest, manifest->hash,manifest->verification->base, manifest->pfr_hash->hash_out, manifest->pfr_hash->length);
     if(status != Success){
         DEBUG_PRINTF("staging verify failed\r\n");
         return Failure;
@@ -83,7 +92,7 @@ int pfr_staging_verify(struct pfr_manifest *manifest){
     manifest->address += PFM_SIG_BLOCK_SIZE;
 	
 	//manifest verification
-    status = manifest->base->verify(manifest,manifest->hash,manifest->verification->base, manifest->pfr_hash->hash_out, manifest->pfr_hash->length);
+    status = intel_pfr_manifest_verify((struct manifest *)manifest, manifest->hash,manifest->verification->base, manifest->pfr_hash->hash_out, manifest->pfr_hash->length);
     if(status != Success){
         DEBUG_PRINTF("staging verify failed\r\n");
         return Failure;
@@ -116,6 +125,14 @@ int set_ufm_svn(struct pfr_manifest *manifest, uint8_t ufm_location, uint8_t svn
     uint8_t remain = svn_number % 8;
     uint8_t index = 0;
 
+#if UFM_POLICY_SHADOW_SUPPORT
+	uint8_t current_svn;
+
+	// Every UFM write erases and rewrites the provisioning sector, skip it when nothing changes
+	if (ufm_policy_get_svn(ufm_location, &current_svn) == Success && current_svn == svn_number)
+		return Success;
+#endif
+
     memset(svn_buffer,0xFF,sizeof(svn_buffer));
     for (index = 0; index < offset;index ++){
         svn_buffer[index] = 0x00;
@@ -130,14 +147,37 @@ int set_ufm_svn(struct pfr_manifest *manifest, uint8_t ufm_location, uint8_t svn
 	return Success;
 }
 
+/**
+    Function to read the SVN policy from UFM.  When the policy can't be read the result is
+    above SVN_MAX, the same as a fully consumed policy, so no SVN check can pass on it.
+
+    @Param  manifest    Manifest of the image being checked
+    @Param  offset      SVN policy offset in the provisioning UFM
+
+    @retval int         Current SVN, or SVN_MAX + 1 if the policy can't be read
+**/
 int get_ufm_svn(struct pfr_manifest *manifest, uint8_t offset){
 	
+#if UFM_POLICY_SHADOW_SUPPORT
+	uint8_t svn_number = 0;
+
+	if (ufm_policy_get_svn(offset, &svn_number) != Success) {
+		DEBUG_PRINTF("Get UFM SVN failed\r\n");
+		return SVN_MAX + 1;
+	}
+
+	return svn_number;
+#else
 	uint8_t svn_size = 8; // we have (0- 63) SVN Number in 64 bits
     uint8_t svn_buffer[8];
     uint8_t svn_number = 0 ,index1 = 0,index2 = 0;
     uint8_t mask = 0x01;
     
-    ufm_read(PROVISION_UFM, offset, svn_buffer, sizeof(svn_buffer));
+    if (ufm_read(PROVISION_UFM, offset, svn_buffer, sizeof(svn_buffer)) != Success) {
+		DEBUG_PRINTF("Get UFM SVN failed\r\n");
+		return SVN_MAX + 1;
+	}
+
     for (index1 = 0; index1 < svn_size;index1 ++){
         for (index2 = 0; index2 < svn_size; index2 ++){
             if (/*!*/((svn_buffer[index1] >> index2) & mask)){
@@ -148,6 +188,7 @@ int get_ufm_svn(struct pfr_manifest *manifest, uint8_t offset){
     }
 
 	return svn_number;
+#endif
 }
 
 int  check_hrot_capsule_type(struct pfr_manifest *manifest)
@@ -194,6 +235,15 @@ int pfr_decommission(struct pfr_manifest *manifest)
 
 	// Erasing provisioned data
 	DEBUG_PRINTF("Decommission Success.Erasing the provisioned UFM data\r\n");
+
+#if MEASUREMENT_CACHE_SUPPORT
+	measurement_cache_invalidate(BMC_TYPE);
+	measurement_cache_invalidate(PCH_TYPE);
+#endif
+#if CAPSULE_VERDICT_SUPPORT
+	capsule_verdict_invalidate(BMC_TYPE);
+	capsule_verdict_invalidate(PCH_TYPE);
+#endif
 	
 	status = ufm_erase(PROVISION_UFM);
 	if (status != Success)
@@ -211,6 +261,32 @@ int pfr_decommission(struct pfr_manifest *manifest)
 	return Success;
 }
 
+#if ROT_AB_UPDATE_SUPPORT
+/**
+    Function to check that the RoT flash partitions line up with the strapped ABR slots.  The
+    recovery partition has to be the alternate slot, and the partitions holding state shared by
+    both slots have to sit outside the range the FMC swaps when booting from the alternate slot.
+
+    @retval bool        true if a RoT update can be written to the inactive slot
+**/
+static bool rot_ab_layout_valid(void)
+{
+	uint32_t alternate = abr_alternate_offset();
+	uint32_t remapped = abr_remapped_length();
+
+	if (!abr_is_enabled() || !alternate)
+		return false;
+
+	if (FLASH_AREA_OFFSET(active) != 0 || FLASH_AREA_OFFSET(recovery) != alternate ||
+	    FLASH_AREA_SIZE(active) < ROT_ACTIVE_REGION_LENGTH || FLASH_AREA_SIZE(active) > alternate ||
+	    FLASH_AREA_SIZE(recovery) != FLASH_AREA_SIZE(active))
+		return false;
+
+	return FLASH_AREA_OFFSET(state) >= remapped && FLASH_AREA_OFFSET(intel_state) >= remapped &&
+	       FLASH_AREA_OFFSET(key) >= remapped && FLASH_AREA_OFFSET(log) >= remapped;
+}
+#endif
+
 int update_rot_fw(uint32_t address, uint32_t length){
 	int status = 0;
 	uint32_t source_address = address;
@@ -218,7 +294,25 @@ int update_rot_fw(uint32_t address, uint32_t length){
 
 	uint32_t rot_recovery_address = 0;
 	uint32_t rot_active_address= 0;
-	uint32_t active_length = 0x60000;
+	uint32_t active_length = ROT_ACTIVE_REGION_LENGTH;
+
+#if ROT_AB_UPDATE_SUPPORT
+	if (rot_ab_layout_valid()) {
+		// The copy works on whole sectors, whatever follows the image in the last one is padding
+		uint32_t slot_length = (length + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+
+		if (slot_length > FLASH_AREA_SIZE(recovery))
+			return Failure;
+
+		// Write the new image once into the inactive slot, the running image stays intact
+		status = pfr_spi_copy_and_verify(BMC_SPI, source_address, ROT_INTERNAL_RECOVERY, 0, slot_length);
+		if (status != Success)
+			return Failure;
+
+		abr_request_switch();
+		return Success;
+	}
+#endif
 
 	for(int i = 0; i < (active_length / PAGE_SIZE); i++){
 		pfr_spi_erase_4k(ROT_INTERNAL_RECOVERY, rot_recovery_address);
@@ -271,7 +365,7 @@ int hrot_update(struct pfr_manifest *manifest)
     }
 
     manifest->pc_type = pc_type;
-	status = manifest->base->verify(manifest,manifest->hash,manifest->verification->base, manifest->pfr_hash->hash_out, manifest->pfr_hash->length);
+	status = intel_pfr_manifest_verify((struct manifest *)manifest, manifest->hash,manifest->verification->base, manifest->pfr_hash->hash_out, manifest->pfr_hash->length);
 	if(status != Success){
 		DEBUG_PRINTF("HROT update capsule verification failed\r\n");
 		SetMinorErrorCode(CPLD_UPD_CAPSULE_AUTH_FAIL);
@@ -364,7 +458,16 @@ int check_svn_number(struct pfr_manifest *manifest, uint32_t read_address, uint8
 }
 
 int update_recovery_region(int image_type,uint32_t source_address,uint32_t target_address){
-    return pfr_recover_recovery_region(image_type,source_address,target_address);
+    int status = 0;
+
+    status = pfr_recover_recovery_region(image_type,source_address,target_address);
+#if CAPSULE_VERDICT_SUPPORT
+    // The copy matched the staging capsule that was just authenticated
+    if (status == Success)
+        capsule_verdict_record_copy(get_pfr_manifest(), target_address);
+#endif
+
+    return status;
 }
 
 int update_firmware_image(uint32_t image_type, void* EventContext)
@@ -442,7 +545,7 @@ int update_firmware_image(uint32_t image_type, void* EventContext)
 	//Staging area verification
 	DEBUG_PRINTF("Staging Area verification \r\n");
 	// status = pfr_staging_verify(pfr_manifest);
-	status = pfr_manifest->update_fw->base->verify(pfr_manifest, NULL, NULL);
+	status = intel_pfr_update_verify((struct firmware_image *)pfr_manifest, NULL, NULL);
 	if(status != Success){
 		DEBUG_PRINTF("Staging Area verification failed\r\n");
 		SetMinorErrorCode(FW_UPD_CAPSULE_AUTH_FAIL);
@@ -455,7 +558,7 @@ int update_firmware_image(uint32_t image_type, void* EventContext)
 	area_size = pfr_manifest->update_fw->pc_length - (PFM_SIG_BLOCK_SIZE + pfr_manifest->update_fw->pfm_length);
 
 	if(flash_select == PRIMARY_FLASH_REGION){
-		status = pfr_manifest->recovery_base->verify(pfr_manifest, pfr_manifest->hash, pfr_manifest->verification->base, pfr_manifest->pfr_hash->hash_out, pfr_manifest->pfr_hash->length, pfr_manifest->recovery_pfm);
+		status = intel_pfr_recovery_verify((struct recovery_image *)pfr_manifest, pfr_manifest->hash, pfr_manifest->verification->base, pfr_manifest->pfr_hash->hash_out, pfr_manifest->pfr_hash->length, pfr_manifest->recovery_pfm);
 		if(status == Failure){
 			DEBUG_PRINTF("Recovery Region Verify Fail, Update Active Region is not allowed. \r\n");
 			return Failure;
@@ -515,32 +618,19 @@ int update_firmware_image(uint32_t image_type, void* EventContext)
 	return Success;
 }
 
-void get_region_type(CPLD_STATUS region){
-	
-	if(region.CpldStatus == 1) {
-		if(region.Region[0].ActiveRegion == 1) {
-				DataContext.flash = PRIMARY_FLASH_REGION;
-		}
-		if(region.Region[0].Recoveryregion == 1 && region.Region[0].ActiveRegion == 0) {
-			DataContext.flash = SECONDARY_FLASH_REGION;
-		}
-	}
-	if(region.BmcStatus == 1) {
-		if(region.Region[1].ActiveRegion == 1 || (region.Region[1].Recoveryregion == 1 && region.Region[1].ActiveRegion == 1)) {
-				DataContext.flash = PRIMARY_FLASH_REGION;
-		}
-		if(region.Region[1].Recoveryregion == 1 && region.Region[1].ActiveRegion == 0) {
-			DataContext.flash = SECONDARY_FLASH_REGION;
-		}
-	}
-	if(region.PchStatus == 1) {
-		if((region.Region[2].ActiveRegion == 1) || (region.Region[2].Recoveryregion == 1 && region.Region[2].ActiveRegion == 1)) {
-				DataContext.flash = PRIMARY_FLASH_REGION;
-		}
-		if(region.Region[2].Recoveryregion == 1 && region.Region[2].ActiveRegion == 0) {
-			DataContext.flash = SECONDARY_FLASH_REGION;
-		}
-	}
+/**
+    Function to select the flash region a pending update targets
+
+    @Param  region      Pending update bits of one image
+
+    @retval uint32_t    PRIMARY_FLASH_REGION or SECONDARY_FLASH_REGION
+**/
+static uint32_t get_region_type(UPD_REGION region){
+
+	if(region.Recoveryregion == 1 && region.ActiveRegion == 0)
+		return SECONDARY_FLASH_REGION;
+
+	return PRIMARY_FLASH_REGION;
 }
 
 void watchdog_timer(uint32_t image_type){
@@ -552,89 +642,98 @@ void watchdog_timer(uint32_t image_type){
 #endif
 }
 
-int check_staging_area() {
-
+/*
+ * Updates pending at reset, one job per image.  Each job only owns its own status byte and
+ * Region entry in CPLD_STATUS.  The RoT job runs first since a successful RoT update reboots.
+ * The PCH job has to follow the BMC job: with BmcToPchStatus set the BMC job copies the PCH
+ * capsule from the BMC staging area into the PCH staging area the PCH job then reads.
+ *
+ * The jobs run one after another on this thread.  Unlike the copy writer, which only ever uses its
+ * own spi_flash instance, an update goes through get_pfr_manifest() and the pfr_spi_* helpers,
+ * which select the device on the shared SPI engine before every transfer.  Its authentication and
+ * copy also keep the single hash session open across all their reads, so with the hash engine
+ * serialized the jobs would still run one at a time.
+ */
+struct staging_job {
+	uint32_t image_type;
+	uint8_t status_offset;		// Pending flag in CPLD_STATUS
+	uint8_t region;			// Index into CPLD_STATUS.Region
+};
+
+static const struct staging_job staging_jobs[] = {
+	{ HROT_TYPE, offsetof(CPLD_STATUS, CpldStatus), 0 },
+	{ BMC_TYPE, offsetof(CPLD_STATUS, BmcStatus), 1 },
+	{ PCH_TYPE, offsetof(CPLD_STATUS, PchStatus), 2 },
+};
+
+/**
+    Function to run one pending update and clear its status once it is done with
+
+    @Param  job         Pending update job
+
+    @retval int         Success or Failure
+**/
+static int run_staging_job(const struct staging_job *job)
+{
 	int status = 0;
-    uint32_t pc_length, read_address, pc_type;
-    uint8_t	active_svn_number = 0;
-    int flash_id;
-	void *AoData = NULL;
-    
-	DEBUG_PRINTF("Check Staging Area\r\n");
-    CPLD_STATUS cpld_update_status;
-	
+	int update_status = 0;
+	UPD_REGION region;
+	CPLD_STATUS cpld_update_status;
+
 	status = ufm_read(UPDATE_STATUS_UFM, UPDATE_STATUS_ADDRESS, (uint8_t *)&cpld_update_status, sizeof(CPLD_STATUS));
-    if (status != Success)
+	if (status != Success)
 		return Failure;
 
-    if(cpld_update_status.CpldStatus == 1) {
-		DEBUG_PRINTF("CPLD Check\r\n");
-    	get_region_type(cpld_update_status);
-		DataContext.image = HROT_TYPE;
-		flash_id = BMC_TYPE;
-		
-		// Checking CPLD staging area
-		status = handle_update_image_action(HROT_TYPE, &DataContext);
-		if(status == Success) {
-			DEBUG_PRINTF("SuccessFully updated cpld\r\n");
-			cpld_update_status.CpldStatus = 0;
-			cpld_update_status.Region[0].ActiveRegion = 0;
-			ufm_write(UPDATE_STATUS_UFM, UPDATE_STATUS_ADDRESS,(uint8_t *)&cpld_update_status, sizeof(CPLD_STATUS));
-		}
-    }
+	if (((uint8_t *)&cpld_update_status)[job->status_offset] != 1)
+		return Success;
 
-    if(cpld_update_status.BmcStatus == 1) {
-    	DEBUG_PRINTF("BMC check\r\n");
-		get_region_type(cpld_update_status);
-		flash_id = BMC_TYPE;
-		DataContext.image = flash_id;
-		// Checking BMC staging area
-		status = handle_update_image_action(flash_id, &DataContext);
-		if(status == Success){
-			if(cpld_update_status.Region[1].ActiveRegion == 1 && cpld_update_status.Region[1].Recoveryregion == 1){
-				watchdog_timer(BMC_TYPE);
-			}
-			else if((cpld_update_status.Region[1].ActiveRegion == 1)
-				||(cpld_update_status.Region[1].Recoveryregion == 1)){
-				cpld_update_status.BmcStatus = 0;
-				cpld_update_status.Region[1].ActiveRegion = 0;
-				cpld_update_status.Region[1].Recoveryregion = 0;
-				status = ufm_write(UPDATE_STATUS_UFM, UPDATE_STATUS_ADDRESS, (uint8_t *)&cpld_update_status, sizeof(CPLD_STATUS));
-			}
-		} else {
-			cpld_update_status.BmcStatus = 0;
-			cpld_update_status.Region[1].ActiveRegion = 0;
-			cpld_update_status.Region[1].Recoveryregion = 0;
-			status = ufm_write(UPDATE_STATUS_UFM, UPDATE_STATUS_ADDRESS,(uint8_t *)&cpld_update_status, sizeof(CPLD_STATUS));
-		}
-    }
+	DEBUG_PRINTF("Image %d check\r\n", job->image_type);
+	region = cpld_update_status.Region[job->region];
+	DataContext.image = job->image_type;
+	DataContext.flash = get_region_type(region);
 
-    if(cpld_update_status.PchStatus == 1) {
-    	DEBUG_PRINTF("PCH check\r\n");
-		// Checking PCH staging area
-    	flash_id = PCH_TYPE;
-		
-		get_region_type(cpld_update_status);
-		DataContext.image = flash_id;
-		status = handle_update_image_action(flash_id, &DataContext);
-		if(status == Success){
-			if(cpld_update_status.Region[2].ActiveRegion == 1 && cpld_update_status.Region[2].Recoveryregion == 1){
-				watchdog_timer(PCH_TYPE);
-			}
-			else if((cpld_update_status.Region[2].ActiveRegion == 1)||(cpld_update_status.Region[2].Recoveryregion == 1)){
-				cpld_update_status.PchStatus = 0;
-				cpld_update_status.Region[2].ActiveRegion = 0;
-				cpld_update_status.Region[2].Recoveryregion = 0;
-				status = ufm_write(UPDATE_STATUS_UFM, UPDATE_STATUS_ADDRESS, (uint8_t *)&cpld_update_status, sizeof(CPLD_STATUS));
-			}
-		} else {
-			cpld_update_status.PchStatus = 0;
-			cpld_update_status.Region[2].ActiveRegion = 0;
-			cpld_update_status.Region[2].Recoveryregion = 0;
-			status = ufm_write(UPDATE_STATUS_UFM, UPDATE_STATUS_ADDRESS,(uint8_t *)&cpld_update_status, sizeof(CPLD_STATUS));
-		}
+	update_status = handle_update_image_action(job->image_type, &DataContext);
+
+	if (job->image_type == HROT_TYPE) {
+		// A failed RoT update stays pending
+		if (update_status != Success)
+			return update_status;
+	} else if (update_status == Success && region.ActiveRegion == 1 && region.Recoveryregion == 1) {
+		watchdog_timer(job->image_type);
+		return update_status;
 	}
 
-   return status;
+	// The update may have changed other fields, only clear this job's own
+	status = ufm_read(UPDATE_STATUS_UFM, UPDATE_STATUS_ADDRESS, (uint8_t *)&cpld_update_status, sizeof(CPLD_STATUS));
+	if (status != Success)
+		return Failure;
+
+	((uint8_t *)&cpld_update_status)[job->status_offset] = 0;
+	cpld_update_status.Region[job->region].ActiveRegion = 0;
+	if (job->image_type != HROT_TYPE)
+		cpld_update_status.Region[job->region].Recoveryregion = 0;
+
+	status = ufm_write(UPDATE_STATUS_UFM, UPDATE_STATUS_ADDRESS, (uint8_t *)&cpld_update_status, sizeof(CPLD_STATUS));
+
+#if ROT_AB_UPDATE_SUPPORT
+	// The new RoT image only takes effect through the ABR switch, which isn't kept across a reset
+	if (job->image_type == HROT_TYPE && abr_switch_requested())
+		pfr_cpld_update_reboot();
+#endif
+
+	return status;
+}
+
+int check_staging_area() {
+
+	int status = 0;
+	int i;
+
+	DEBUG_PRINTF("Check Staging Area\r\n");
+
+	for (i = 0; i < ARRAY_SIZE(staging_jobs); i++)
+		status = run_staging_job(&staging_jobs[i]);
+
+	return status;
 }
 #endif
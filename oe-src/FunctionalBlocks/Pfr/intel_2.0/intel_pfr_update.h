@@ -12,5 +12,7 @@
 #include <stdint.h>
 
 int intel_pfr_update_verify (struct firmware_image *fw, struct hash_engine *hash, struct rsa_engine *rsa);
+int get_ufm_svn(struct pfr_manifest *manifest, uint8_t offset);
+int check_svn_number(struct pfr_manifest *manifest, uint32_t read_address, uint8_t current_svn_number);
 
 #endif /*INTEL_PFR_UPDATE_H_*/
\ No newline at end of file
@@ -0,0 +1,267 @@
+//***********************************************************************//
+//*                                                                     *//
+//*                      Copyright © 2022 AMI                           *//
+//*                                                                     *//
+//*        All rights reserved. Subject to AMI licensing agreement.     *//
+//*                                                                     *//
+//***********************************************************************//
+#if CONFIG_INTEL_PFR_SUPPORT
+#include <stdbool.h>
+#include <string.h>
+#include "state_machine/common_smc.h"
+#include "flash/flash_aspeed.h"
+#include "pfr/pfr_common.h"
+#include "pfr/pfr_util.h"
+#include "Common.h"
+#include "intel_pfr_definitions.h"
+#include "intel_pfr_update_checkpoint.h"
+
+#undef DEBUG_PRINTF
+#if PF_UPDATE_DEBUG
+#define DEBUG_PRINTF printk
+#else
+#define DEBUG_PRINTF(...)
+#endif
+
+/*
+ * Update and recovery progress checkpoint.
+ *
+ * A long running write to an active region records its progress on the RoT internal state
+ * partition: a header naming the operation and the capsule it copies from, followed by an
+ * append-only log of (phase, page) entries written every UPDATE_CHECKPOINT_INTERVAL bytes of the
+ * target.  Entries are programmed into erased flash one at a time, so the sector is only erased
+ * when an operation starts, when the log fills up and when the operation completes.  Each entry
+ * carries its complement, so one torn by a reset during the write is skipped.  If the RoT is
+ * reset part way through, the same operation from the same capsule picks up at the last entry.
+ */
+
+static UPDATE_CHECKPOINT checkpoint;
+static bool checkpoint_active;
+static uint32_t checkpoint_entries;
+static uint32_t checkpoint_phase;
+static uint32_t checkpoint_page;
+
+/**
+    Function to hash the signature block of the source capsule, which binds the checkpoint to
+    the authenticated capsule contents
+
+    @Param  image_type      BMC_TYPE or PCH_TYPE
+    @Param  source_address  Capsule offset
+    @Param  digest          Output buffer, SHA256_DIGEST_LENGTH bytes
+
+    @retval int             Success or Failure
+**/
+static int update_checkpoint_source_digest(uint32_t image_type, uint32_t source_address, uint8_t *digest)
+{
+	struct hash_engine *hash = get_hash_engine_instance();
+	uint8_t signature_block[PFM_SIG_BLOCK_SIZE];
+	int status = 0;
+
+	status = pfr_spi_read(image_type, source_address, sizeof(signature_block), signature_block);
+	if (status != Success)
+		return Failure;
+
+	return hash->calculate_sha256(hash, signature_block, sizeof(signature_block), digest, SHA256_DIGEST_LENGTH);
+}
+
+static int update_checkpoint_write_header(void)
+{
+	int status = 0;
+
+	status = pfr_spi_erase_4k(ROT_INTERNAL_STATE, UPDATE_CHECKPOINT_ADDRESS);
+	if (status != Success)
+		return Failure;
+
+	checkpoint_entries = 0;
+	return pfr_spi_write(ROT_INTERNAL_STATE, UPDATE_CHECKPOINT_ADDRESS, sizeof(checkpoint), (uint8_t *)&checkpoint);
+}
+
+/**
+    Function to find the last valid entry of the progress log.  Entries whose complement does not
+    match were torn by a reset while being written and are skipped.
+
+    @Param  entry   Output for the last valid entry, untouched if there is none
+
+    @retval uint32_t    Number of entry slots in use, valid or not
+**/
+static uint32_t update_checkpoint_last_entry(uint32_t *entry)
+{
+	UPDATE_CHECKPOINT_ENTRY log[32];
+	uint32_t count = 0;
+	int i;
+
+	while (count < UPDATE_CHECKPOINT_LOG_ENTRIES) {
+		if (pfr_spi_read(ROT_INTERNAL_STATE, UPDATE_CHECKPOINT_ADDRESS + UPDATE_CHECKPOINT_LOG_OFFSET + (count * sizeof(UPDATE_CHECKPOINT_ENTRY)),
+				sizeof(log), (uint8_t *)log) != Success)
+			break;
+
+		for (i = 0; i < ARRAY_SIZE(log) && count < UPDATE_CHECKPOINT_LOG_ENTRIES; i++, count++) {
+			if (log[i].Progress == 0xFFFFFFFF && log[i].Check == 0xFFFFFFFF)
+				return count;
+			if (log[i].Check == ~log[i].Progress)
+				*entry = log[i].Progress;
+		}
+	}
+
+	return count;
+}
+
+/**
+    Function to start or resume a checkpointed operation
+
+    @Param  operation       CHECKPOINT_OP_*
+    @Param  image_type      BMC_TYPE or PCH_TYPE
+    @Param  source_address  Offset of the authenticated source capsule
+    @Param  length          Size of the source area
+    @Param  phase           Output, phase to resume in, 0 to start from the beginning
+    @Param  page            Output, first page of the phase that is not complete
+
+    @retval int             Success if progress is being recorded, Failure otherwise
+**/
+int update_checkpoint_open(uint8_t operation, uint32_t image_type, uint32_t source_address,
+	uint32_t length, uint32_t *phase, uint32_t *page)
+{
+	uint8_t digest[SHA256_DIGEST_LENGTH];
+	uint32_t entry = 0;
+	int status = 0;
+
+	*phase = 0;
+	*page = 0;
+	checkpoint_active = false;
+
+	status = update_checkpoint_source_digest(image_type, source_address, digest);
+	if (status != Success)
+		return Failure;
+
+	status = pfr_spi_read(ROT_INTERNAL_STATE, UPDATE_CHECKPOINT_ADDRESS, sizeof(checkpoint), (uint8_t *)&checkpoint);
+	if (status == Success &&
+	    checkpoint.Magic == UPDATE_CHECKPOINT_MAGIC &&
+	    checkpoint.Version == UPDATE_CHECKPOINT_VERSION &&
+	    checkpoint.Operation == operation &&
+	    checkpoint.ImageType == image_type &&
+	    checkpoint.SourceAddress == source_address &&
+	    checkpoint.Length == length &&
+	    compare_buffer(checkpoint.SourceDigest, digest, SHA256_DIGEST_LENGTH) == Success) {
+		checkpoint_entries = update_checkpoint_last_entry(&entry);
+		if (checkpoint_entries) {
+			*phase = CHECKPOINT_ENTRY_PHASE(entry);
+			*page = CHECKPOINT_ENTRY_PAGE(entry);
+			DEBUG_PRINTF("Resuming from checkpoint, phase %d page %x\r\n", *phase, *page);
+		}
+		checkpoint_phase = *phase;
+		checkpoint_page = *page;
+		checkpoint_active = true;
+		return Success;
+	}
+
+	memset(&checkpoint, 0, sizeof(checkpoint));
+	checkpoint.Magic = UPDATE_CHECKPOINT_MAGIC;
+	checkpoint.Version = UPDATE_CHECKPOINT_VERSION;
+	checkpoint.Operation = operation;
+	checkpoint.ImageType = image_type;
+	checkpoint.SourceAddress = source_address;
+	checkpoint.Length = length;
+	memcpy(checkpoint.SourceDigest, digest, SHA256_DIGEST_LENGTH);
+
+	status = update_checkpoint_write_header();
+	if (status != Success)
+		return Failure;
+
+	checkpoint_phase = 0;
+	checkpoint_page = 0;
+	checkpoint_active = true;
+	return Success;
+}
+
+/**
+    Function to record that every page of a phase below the given page is complete.
+    Only one entry per UPDATE_CHECKPOINT_INTERVAL is written, phase changes are always recorded.
+
+    @Param  phase   Current phase
+    @Param  page    First page that is not complete yet
+**/
+void update_checkpoint_progress(uint32_t phase, uint32_t page)
+{
+	UPDATE_CHECKPOINT_ENTRY entry;
+	UPDATE_CHECKPOINT_ENTRY written;
+	uint32_t address;
+
+	if (!checkpoint_active)
+		return;
+
+	if (phase == checkpoint_phase && page < checkpoint_page + (UPDATE_CHECKPOINT_INTERVAL / PAGE_SIZE))
+		return;
+
+	if (checkpoint_entries >= UPDATE_CHECKPOINT_LOG_ENTRIES) {
+		if (update_checkpoint_write_header() != Success) {
+			checkpoint_active = false;
+			return;
+		}
+	}
+
+	entry.Progress = CHECKPOINT_ENTRY(phase, page);
+	entry.Check = ~entry.Progress;
+	address = UPDATE_CHECKPOINT_ADDRESS + UPDATE_CHECKPOINT_LOG_OFFSET + (checkpoint_entries * sizeof(UPDATE_CHECKPOINT_ENTRY));
+	checkpoint_entries++;
+
+	// Read the entry back, the flash wrapper does not report every failed program
+	if (pfr_spi_write(ROT_INTERNAL_STATE, address, sizeof(entry), (uint8_t *)&entry) != Success ||
+	    pfr_spi_read(ROT_INTERNAL_STATE, address, sizeof(written), (uint8_t *)&written) != Success ||
+	    memcmp(&entry, &written, sizeof(entry))) {
+		// Stop recording and drop the checkpoint, an interrupted operation then starts over
+		DEBUG_PRINTF("Checkpoint write failed\r\n");
+		checkpoint_active = false;
+		pfr_spi_erase_4k(ROT_INTERNAL_STATE, UPDATE_CHECKPOINT_ADDRESS);
+		return;
+	}
+
+	checkpoint_phase = phase;
+	checkpoint_page = page;
+}
+
+/**
+    Function to drop the checkpoint once the operation has completed
+**/
+void update_checkpoint_close(void)
+{
+	if (!checkpoint_active)
+		return;
+
+	checkpoint_active = false;
+	pfr_spi_erase_4k(ROT_INTERNAL_STATE, UPDATE_CHECKPOINT_ADDRESS);
+}
+
+/**
+    Function to check for an interrupted operation on an image that can be resumed from the
+    capsule now at source_address.  A checkpoint left by a different capsule is discarded.
+
+    @Param  operation       CHECKPOINT_OP_*
+    @Param  image_type      BMC_TYPE or PCH_TYPE
+    @Param  source_address  Offset of the capsule the operation would be resumed from
+
+    @retval int             Success if an interrupted operation from this capsule was found
+**/
+int update_checkpoint_pending(uint8_t operation, uint32_t image_type, uint32_t source_address)
+{
+	uint8_t digest[SHA256_DIGEST_LENGTH];
+	UPDATE_CHECKPOINT header;
+
+	if (pfr_spi_read(ROT_INTERNAL_STATE, UPDATE_CHECKPOINT_ADDRESS, sizeof(header), (uint8_t *)&header) != Success)
+		return Failure;
+
+	if (header.Magic != UPDATE_CHECKPOINT_MAGIC || header.Version != UPDATE_CHECKPOINT_VERSION ||
+	    header.Operation != operation || header.ImageType != image_type)
+		return Failure;
+
+	if (header.SourceAddress == source_address &&
+	    update_checkpoint_source_digest(image_type, source_address, digest) == Success &&
+	    compare_buffer(header.SourceDigest, digest, SHA256_DIGEST_LENGTH) == Success)
+		return Success;
+
+	// The capsule the operation was copying from is gone
+	DEBUG_PRINTF("Discarding stale checkpoint\r\n");
+	pfr_spi_erase_4k(ROT_INTERNAL_STATE, UPDATE_CHECKPOINT_ADDRESS);
+	return Failure;
+}
+
+#endif
@@ -0,0 +1,58 @@
+//***********************************************************************//
+//*                                                                     *//
+//*                      Copyright © 2022 AMI                           *//
+//*                                                                     *//
+//*        All rights reserved. Subject to AMI licensing agreement.     *//
+//*                                                                     *//
+//***********************************************************************//
+
+#ifndef INTEL_PFR_UPDATE_CHECKPOINT_H_
+#define INTEL_PFR_UPDATE_CHECKPOINT_H_
+
+#include <stdint.h>
+#include "intel_pfr_definitions.h"
+
+#define UPDATE_CHECKPOINT_MAGIC		0x55434B50	// "UCKP"
+#define UPDATE_CHECKPOINT_VERSION	2
+#define UPDATE_CHECKPOINT_LOG_OFFSET	0x40
+#define UPDATE_CHECKPOINT_LOG_ENTRIES	((UPDATE_CHECKPOINT_SIZE - UPDATE_CHECKPOINT_LOG_OFFSET) / sizeof(UPDATE_CHECKPOINT_ENTRY))
+
+// Operations that can be resumed
+#define CHECKPOINT_OP_DECOMPRESSION	1
+
+// Phases of CHECKPOINT_OP_DECOMPRESSION
+#define CHECKPOINT_PHASE_ERASE		1
+#define CHECKPOINT_PHASE_WRITE		2
+
+// Progress log entry value, an erased entry (all 0xFF) marks the end of the log
+#define CHECKPOINT_ENTRY(phase, page)	(((uint32_t)(phase) << 24) | ((page) & 0x00FFFFFF))
+#define CHECKPOINT_ENTRY_PHASE(entry)	((entry) >> 24)
+#define CHECKPOINT_ENTRY_PAGE(entry)	((entry) & 0x00FFFFFF)
+
+#pragma pack(1)
+
+typedef struct _UPDATE_CHECKPOINT {
+	uint32_t Magic;
+	uint8_t  Version;
+	uint8_t  Operation;
+	uint8_t  ImageType;
+	uint8_t  Reserved;
+	uint32_t SourceAddress;
+	uint32_t Length;
+	uint8_t  SourceDigest[SHA256_DIGEST_LENGTH];	// SHA256 of the capsule signature block
+} UPDATE_CHECKPOINT;
+
+typedef struct _UPDATE_CHECKPOINT_ENTRY {
+	uint32_t Progress;	// CHECKPOINT_ENTRY(phase, page)
+	uint32_t Check;		// ~Progress, a torn write leaves the pair inconsistent
+} UPDATE_CHECKPOINT_ENTRY;
+
+#pragma pack()
+
+int update_checkpoint_open(uint8_t operation, uint32_t image_type, uint32_t source_address,
+	uint32_t length, uint32_t *phase, uint32_t *page);
+void update_checkpoint_progress(uint32_t phase, uint32_t page);
+void update_checkpoint_close(void);
+int update_checkpoint_pending(uint8_t operation, uint32_t image_type, uint32_t source_address);
+
+#endif /*INTEL_PFR_UPDATE_CHECKPOINT_H_*/
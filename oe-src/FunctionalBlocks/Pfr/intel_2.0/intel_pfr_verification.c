@@ -7,6 +7,8 @@
 //***********************************************************************//
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
 #include "state_machine/common_smc.h"
 #include "pfr/pfr_common.h"
 #include "intel_pfr_definitions.h"
@@ -14,6 +16,7 @@
 #include "intel_pfr_provision.h"
 #include "intel_pfr_key_cancellation.h"
 #include "intel_pfr_verification.h"
+#include "intel_pfr_capsule_verdict.h"
 
 #undef DEBUG_PRINTF
 #if PFR_AUTHENTICATION_DEBUG
@@ -95,7 +98,7 @@ int intel_block1_block0_entry_verify(struct pfr_manifest *manifest)
 		return Failure;
 	}
 
-	status = manifest->base->get_hash(manifest, manifest->hash, manifest->pfr_hash->hash_out, hash_length);
+	status = get_hash((struct manifest *)manifest, manifest->hash, manifest->pfr_hash->hash_out, hash_length);
 	if(status != Success){
 		return Failure;
 	}
@@ -108,7 +111,7 @@ int intel_block1_block0_entry_verify(struct pfr_manifest *manifest)
 	memcpy(manifest->verification->pubkey->signature_r, block1_buffer->Block0SignatureR, hash_length);
 	memcpy(manifest->verification->pubkey->signature_s, block1_buffer->Block0SignatureS, hash_length);
 
-	status = manifest->verification->base->verify_signature(manifest, manifest->pfr_hash->hash_out, hash_length, signature, (2 * hash_length));
+	status = verify_signature((struct signature_verification *)manifest, manifest->pfr_hash->hash_out, hash_length, signature, (2 * hash_length));
 	if(status != Success)
 		return Failure;
 
@@ -192,7 +195,7 @@ int intel_block1_csk_block0_entry_verify(struct pfr_manifest *manifest)
 		return Failure;
 	}
 	
-	status = manifest->base->get_hash(manifest, manifest->hash, manifest->pfr_hash->hash_out, hash_length);
+	status = get_hash((struct manifest *)manifest, manifest->hash, manifest->pfr_hash->hash_out, hash_length);
 	if(status != Success)
 		return Failure;
 
@@ -202,7 +205,7 @@ int intel_block1_csk_block0_entry_verify(struct pfr_manifest *manifest)
 	// memcpy(&signature[0],&block1_buffer->CskSignatureR[0],hash_length);
 	// memcpy(&signature[hash_length],&block1_buffer->CskSignatureS[0],hash_length);
 
-	status = manifest->verification->base->verify_signature(manifest, manifest->pfr_hash->hash_out, hash_length, signature, (2 * hash_length));
+	status = verify_signature((struct signature_verification *)manifest, manifest->pfr_hash->hash_out, hash_length, signature, (2 * hash_length));
 	if(status != Success)
 		return Failure;
 
@@ -269,6 +272,79 @@ int intel_block1_verify(struct pfr_manifest *manifest)
 	return Success;
 }
 
+#if NESTED_PFM_DIGEST_SUPPORT
+/*
+ * Recovery and staging capsules carry a signed PFM at the start of their protected content, and
+ * the PFM is authenticated right after the capsule.  Its protected content digest is calculated
+ * in the same flash pass as the capsule digest and handed to the next Block0 verification, so the
+ * PFM body is not read a second time.  The digest is only published once the capsule digest
+ * matched, and it is dropped by the next Block0 verification whether it is used or not.
+ */
+static struct {
+	bool pending;
+	bool valid;
+	uint32_t image_type;
+	uint32_t start_address;
+	uint32_t length;
+	uint32_t type;
+	uint8_t digest[SHA384_DIGEST_LENGTH];
+} nested_pfm_digest;
+
+/**
+    Function to hash the protected content described by manifest->pfr_hash.  The digest of
+    the PFM inside a capsule is taken in the same pass.
+
+    @Param  manifest    PFR manifest with pfr_hash set up for the protected content
+    @Param  pc_type     Protected content type from Block0
+    @Param  take        Whether the digest handed over by the previous Block0 may be used
+    @Param  hash_out    Output buffer
+    @Param  hash_length Digest length
+
+    @retval int         Success or Failure
+**/
+static int intel_block0_pc_hash(struct pfr_manifest *manifest, uint32_t pc_type, bool take, uint8_t *hash_out,
+	uint32_t hash_length)
+{
+	PFR_AUTHENTICATION_BLOCK0 pfm_block0;
+	struct pfr_hash_region outer;
+	struct pfr_hash_region inner;
+
+	if (take &&
+	    nested_pfm_digest.image_type == manifest->image_type &&
+	    nested_pfm_digest.start_address == manifest->pfr_hash->start_address &&
+	    nested_pfm_digest.length == manifest->pfr_hash->length &&
+	    nested_pfm_digest.type == manifest->pfr_hash->type) {
+		memcpy(hash_out, nested_pfm_digest.digest, hash_length);
+		DEBUG_PRINTF("PFM digest taken from the capsule pass\r\n");
+		return Success;
+	}
+
+	if (pc_type != PFR_BMC_UPDATE_CAPSULE && pc_type != PFR_PCH_UPDATE_CAPSULE)
+		return get_hash((struct manifest *)manifest, manifest->hash, hash_out, hash_length);
+
+	if (pfr_spi_read(manifest->image_type, manifest->pfr_hash->start_address, sizeof(pfm_block0),
+		(uint8_t *)&pfm_block0) != Success || pfm_block0.Block0Tag != BLOCK0TAG)
+		return get_hash((struct manifest *)manifest, manifest->hash, hash_out, hash_length);
+
+	outer.start_address = manifest->pfr_hash->start_address;
+	outer.length = manifest->pfr_hash->length;
+	inner.start_address = outer.start_address + PFM_SIG_BLOCK_SIZE;
+	inner.length = pfm_block0.PcLength;
+
+	if (pfr_spi_hash_nested(manifest->flash->device_id[0], &outer, &inner, manifest->pfr_hash->type,
+		hash_out, nested_pfm_digest.digest, hash_length) != Success)
+		return get_hash((struct manifest *)manifest, manifest->hash, hash_out, hash_length);
+
+	nested_pfm_digest.pending = true;
+	nested_pfm_digest.image_type = manifest->image_type;
+	nested_pfm_digest.start_address = inner.start_address;
+	nested_pfm_digest.length = inner.length;
+	nested_pfm_digest.type = manifest->pfr_hash->type;
+
+	return Success;
+}
+#endif
+
 //BLOCK 0
 uint8_t intel_block0_verify(struct pfr_manifest *manifest)
 {
@@ -279,6 +355,13 @@ uint8_t intel_block0_verify(struct pfr_manifest *manifest)
 	uint8_t block0_hash_match = 0;
 	uint8_t buffer[sizeof(PFR_AUTHENTICATION_BLOCK0)] = {0};
 	uint8_t sha_buffer[SHA384_DIGEST_LENGTH] = {0};
+#if NESTED_PFM_DIGEST_SUPPORT
+	bool take_nested_digest = nested_pfm_digest.valid;
+
+	// Handed over to this verification only, early returns included
+	nested_pfm_digest.valid = false;
+	nested_pfm_digest.pending = false;
+#endif
 
 	status = pfr_spi_read(manifest->image_type,manifest->address, sizeof(PFR_AUTHENTICATION_BLOCK0), buffer);
 	if(status != Success){
@@ -341,8 +424,19 @@ uint8_t intel_block0_verify(struct pfr_manifest *manifest)
 	}else{
 		return Failure;
 	}
+
+#if CAPSULE_VERDICT_SUPPORT
+	if (capsule_verdict_lookup(manifest, pc_type_status, buffer)) {
+		DEBUG_PRINTF("Block0 Hash Matched (cached)..\r\n");
+		return Success;
+	}
+#endif
 	
-	status = manifest->base->get_hash(manifest, manifest->hash, sha_buffer, hash_length);
+#if NESTED_PFM_DIGEST_SUPPORT
+	status = intel_block0_pc_hash(manifest, pc_type_status, take_nested_digest, sha_buffer, hash_length);
+#else
+	status = get_hash((struct manifest *)manifest, manifest->hash, sha_buffer, hash_length);
+#endif
 	if(status != Success)
 		return Failure;
 
@@ -351,6 +445,16 @@ uint8_t intel_block0_verify(struct pfr_manifest *manifest)
 		DEBUG_PRINTF(" Block0 Verification failed..\r\n");
 		return Failure;
 	}
+
+#if NESTED_PFM_DIGEST_SUPPORT
+	// The capsule is authentic, so the PFM digest taken with it can be used
+	nested_pfm_digest.valid = nested_pfm_digest.pending;
+	nested_pfm_digest.pending = false;
+#endif
+
+#if CAPSULE_VERDICT_SUPPORT
+	capsule_verdict_record(manifest, pc_type_status, buffer);
+#endif
 		
 	if (pc_type_status == PFR_CPLD_UPDATE_CAPSULE) {
 		SetCpldFpgaRotHash(&sha_buffer[0]);
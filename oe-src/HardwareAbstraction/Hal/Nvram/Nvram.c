@@ -17,6 +17,270 @@
 #include "Nvram.h"
 #include <string.h>
 
+///
+/// CRC-8 (reflected polynomial 0x8C) of every byte value, one lookup per data byte.
+///
+static const uint8_t NvramCrc8Table[256] = {
+    0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83,
+    0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41,
+    0x9D, 0xC3, 0x21, 0x7F, 0xFC, 0xA2, 0x40, 0x1E,
+    0x5F, 0x01, 0xE3, 0xBD, 0x3E, 0x60, 0x82, 0xDC,
+    0x23, 0x7D, 0x9F, 0xC1, 0x42, 0x1C, 0xFE, 0xA0,
+    0xE1, 0xBF, 0x5D, 0x03, 0x80, 0xDE, 0x3C, 0x62,
+    0xBE, 0xE0, 0x02, 0x5C, 0xDF, 0x81, 0x63, 0x3D,
+    0x7C, 0x22, 0xC0, 0x9E, 0x1D, 0x43, 0xA1, 0xFF,
+    0x46, 0x18, 0xFA, 0xA4, 0x27, 0x79, 0x9B, 0xC5,
+    0x84, 0xDA, 0x38, 0x66, 0xE5, 0xBB, 0x59, 0x07,
+    0xDB, 0x85, 0x67, 0x39, 0xBA, 0xE4, 0x06, 0x58,
+    0x19, 0x47, 0xA5, 0xFB, 0x78, 0x26, 0xC4, 0x9A,
+    0x65, 0x3B, 0xD9, 0x87, 0x04, 0x5A, 0xB8, 0xE6,
+    0xA7, 0xF9, 0x1B, 0x45, 0xC6, 0x98, 0x7A, 0x24,
+    0xF8, 0xA6, 0x44, 0x1A, 0x99, 0xC7, 0x25, 0x7B,
+    0x3A, 0x64, 0x86, 0xD8, 0x5B, 0x05, 0xE7, 0xB9,
+    0x8C, 0xD2, 0x30, 0x6E, 0xED, 0xB3, 0x51, 0x0F,
+    0x4E, 0x10, 0xF2, 0xAC, 0x2F, 0x71, 0x93, 0xCD,
+    0x11, 0x4F, 0xAD, 0xF3, 0x70, 0x2E, 0xCC, 0x92,
+    0xD3, 0x8D, 0x6F, 0x31, 0xB2, 0xEC, 0x0E, 0x50,
+    0xAF, 0xF1, 0x13, 0x4D, 0xCE, 0x90, 0x72, 0x2C,
+    0x6D, 0x33, 0xD1, 0x8F, 0x0C, 0x52, 0xB0, 0xEE,
+    0x32, 0x6C, 0x8E, 0xD0, 0x53, 0x0D, 0xEF, 0xB1,
+    0xF0, 0xAE, 0x4C, 0x12, 0x91, 0xCF, 0x2D, 0x73,
+    0xCA, 0x94, 0x76, 0x28, 0xAB, 0xF5, 0x17, 0x49,
+    0x08, 0x56, 0xB4, 0xEA, 0x69, 0x37, 0xD5, 0x8B,
+    0x57, 0x09, 0xEB, 0xB5, 0x36, 0x68, 0x8A, 0xD4,
+    0x95, 0xCB, 0x29, 0x77, 0xF4, 0xAA, 0x48, 0x16,
+    0xE9, 0xB7, 0x55, 0x0B, 0x88, 0xD6, 0x34, 0x6A,
+    0x2B, 0x75, 0x97, 0xC9, 0x4A, 0x14, 0xF6, 0xA8,
+    0x74, 0x2A, 0xC8, 0x96, 0x15, 0x4B, 0xA9, 0xF7,
+    0xB6, 0xE8, 0x0A, 0x54, 0xD7, 0x89, 0x6B, 0x35
+};
+
+///
+/// Name hash index of the valid variables, built from the store image at NvramInit.
+///
+typedef struct {
+    uint32_t NameHash;
+    uint16_t Offset;        // Offset of the NVRAM_VARIABLE in the store, 0 for an empty slot
+} NVRAM_INDEX_ENTRY;
+
+static uint8_t              gNvramStore[NVRAM_STORE_SIZE];
+static NVRAM_INDEX_ENTRY    gNvramIndex[NVRAM_INDEX_SIZE];
+static uint8_t              gNvramIndexValid = FALSE;
+
+/**
+  @internal
+  Function to hash a variable name (FNV-1a).
+
+  @param IN  char *Name     - Variable name.
+  @param IN  uint32_t Size  - Size of the name in bytes.
+
+  @retval uint32_t name hash.
+  @endinternal
+**/
+static uint32_t NvramNameHash(const char *Name, uint32_t Size)
+{
+    uint32_t Hash = 0x811C9DC5;
+    uint32_t i;
+
+    for (i = 0; i < Size; i++) {
+        Hash ^= (uint8_t)Name[i];
+        Hash *= 0x01000193;
+    }
+    return Hash;
+}
+
+/**
+  @internal
+  Function to get the NVRAM_VARIABLE at an offset of the store image, bounds checked.
+
+  @param IN  uint32_t Offset - Offset of the variable in the store.
+
+  @retval NVRAM_VARIABLE pointer, NULL if the variable does not fit in the store.
+  @endinternal
+**/
+static NVRAM_VARIABLE *NvramVariableAt(uint32_t Offset)
+{
+    NVRAM_VARIABLE *Variable;
+
+    if (Offset + sizeof(NVRAM_VARIABLE) > NVRAM_STORE_SIZE)
+        return NULL;
+
+    Variable = (NVRAM_VARIABLE *)&gNvramStore[Offset];
+    if (memcmp(Variable->signature, NVRAM_SIGNATURE, sizeof(Variable->signature)) != 0)
+        return NULL;
+    if (Variable->VariableNameSize > NVRAM_STORE_SIZE || Variable->VariableLength > NVRAM_STORE_SIZE ||
+        Offset + NVRAM_VARIABLE_TOTAL_SIZE(Variable) > NVRAM_STORE_SIZE)
+        return NULL;
+
+    return Variable;
+}
+
+/**
+  @internal
+  Function to add or replace a variable in the name hash index.
+
+  @param IN  uint32_t Offset - Offset of a valid variable in the store.
+
+  @retval RETURN_SUCCESS if the variable was indexed,
+          RETURN_OUT_OF_RESOURCES if the index is full.
+  @endinternal
+**/
+static RETURN_STATUS NvramIndexInsert(uint32_t Offset)
+{
+    NVRAM_VARIABLE  *Variable = (NVRAM_VARIABLE *)&gNvramStore[Offset];
+    char            *Name = (char *)(Variable + 1);
+    uint32_t        Hash = NvramNameHash(Name, Variable->VariableNameSize);
+    uint32_t        Slot = Hash % NVRAM_INDEX_SIZE;
+    uint32_t        Probe;
+    NVRAM_VARIABLE  *Entry;
+
+    for (Probe = 0; Probe < NVRAM_INDEX_SIZE; Probe++, Slot = (Slot + 1) % NVRAM_INDEX_SIZE) {
+        if (gNvramIndex[Slot].Offset == 0) {
+            gNvramIndex[Slot].NameHash = Hash;
+            gNvramIndex[Slot].Offset = (uint16_t)Offset;
+            return RETURN_SUCCESS;
+        }
+        // A later copy of the same variable replaces the earlier one
+        Entry = (NVRAM_VARIABLE *)&gNvramStore[gNvramIndex[Slot].Offset];
+        if (gNvramIndex[Slot].NameHash == Hash && Entry->VariableNameSize == Variable->VariableNameSize &&
+            memcmp(Entry + 1, Name, Variable->VariableNameSize) == 0) {
+            gNvramIndex[Slot].Offset = (uint16_t)Offset;
+            return RETURN_SUCCESS;
+        }
+    }
+    return RETURN_OUT_OF_RESOURCES;
+}
+
+/**
+  @internal
+  Function to read the store image and rebuild the name hash index from it. Any variable
+  that cannot be indexed leaves the index invalid, and lookups fall back to the store scan.
+
+  @param Nil
+
+  @retval RETURN_SUCCESS if the index was built.
+  @endinternal
+**/
+static RETURN_STATUS NvramIndexBuild(void)
+{
+    NVRAM_HEADER    *Header = (NVRAM_HEADER *)&gNvramStore[0];
+    NVRAM_VARIABLE  *Variable;
+    uint32_t        Offset;
+    uint32_t        End;
+    RETURN_STATUS   Status;
+
+    gNvramIndexValid = FALSE;
+    memset(gNvramIndex, 0, sizeof(gNvramIndex));
+
+    Status = GetNvramStore(&gNvramStore[0], 0);
+    if (Status != RETURN_SUCCESS)
+        return Status;
+
+    if (Header->HeaderLength < sizeof(NVRAM_HEADER) || Header->HeaderLength > NVRAM_STORE_SIZE)
+        return RETURN_ABORTED;
+
+    Offset = Header->HeaderLength;
+    End = (Header->DataStoreSize > NVRAM_STORE_SIZE - Offset) ? NVRAM_STORE_SIZE : Offset + Header->DataStoreSize;
+    while (Offset < End) {
+        Variable = NvramVariableAt(Offset);
+        if (Variable == NULL)
+            break;
+        if (Variable->Flag == FLAG_VALID) {
+            Status = NvramIndexInsert(Offset);
+            if (Status != RETURN_SUCCESS)
+                return Status;
+        }
+        Offset += NVRAM_VARIABLE_TOTAL_SIZE(Variable);
+    }
+
+    gNvramIndexValid = TRUE;
+    return RETURN_SUCCESS;
+}
+
+/**
+  @internal
+  Function to look a variable up through the name hash index.
+
+  @param IN  char *VariableName - Variable name.
+
+  @retval NVRAM_VARIABLE pointer into the store image, NULL if the variable is not indexed.
+  @endinternal
+**/
+static NVRAM_VARIABLE *NvramIndexLookup(char *VariableName)
+{
+    uint32_t        NameSize = strlen(VariableName) + 1;
+    uint32_t        Hash = NvramNameHash(VariableName, NameSize);
+    uint32_t        Slot = Hash % NVRAM_INDEX_SIZE;
+    uint32_t        Probe;
+    NVRAM_VARIABLE  *Variable;
+
+    for (Probe = 0; Probe < NVRAM_INDEX_SIZE && gNvramIndex[Slot].Offset; Probe++, Slot = (Slot + 1) % NVRAM_INDEX_SIZE) {
+        if (gNvramIndex[Slot].NameHash != Hash)
+            continue;
+        Variable = (NVRAM_VARIABLE *)&gNvramStore[gNvramIndex[Slot].Offset];
+        if (Variable->VariableNameSize == NameSize && memcmp(Variable + 1, VariableName, NameSize) == 0)
+            return Variable;
+    }
+    return NULL;
+}
+
+/**
+  @internal
+  Function to mirror a variable just written to the store into the store image and
+  re-point only its index slot. The earlier copy is marked invalid and the new copy is
+  appended after the last variable, the same way the store itself is updated.
+
+  @param IN  char *VariableName         - Variable name.
+  @param IN  uint8_t VariableAttribute  - Variable attribute type.
+  @param IN  uint32_t VariableSize      - Size of the variable data.
+  @param IN  uint8_t *Data              - Variable data.
+
+  @retval RETURN_SUCCESS if the index was updated,
+          RETURN_OUT_OF_RESOURCES if the variable does not fit after the last one (the
+          store had to be compacted) or the index is full.
+  @endinternal
+**/
+static RETURN_STATUS NvramIndexUpdate(char *VariableName, uint8_t VariableAttribute, uint32_t VariableSize, uint8_t *Data)
+{
+    NVRAM_HEADER    *Header = (NVRAM_HEADER *)&gNvramStore[0];
+    NVRAM_VARIABLE  *Variable;
+    uint32_t        NameSize;
+    uint32_t        Offset;
+    uint8_t         *Payload;
+
+    if (VariableName == NULL || (Data == NULL && VariableSize != 0))
+        return RETURN_INVALID_PARAMETER;
+
+    NameSize = strlen(VariableName) + 1;
+    if (NameSize > NVRAM_STORE_SIZE || VariableSize > NVRAM_STORE_SIZE ||
+        Header->DataStoreSize > NVRAM_STORE_SIZE - Header->HeaderLength)
+        return RETURN_OUT_OF_RESOURCES;
+
+    Offset = Header->HeaderLength + Header->DataStoreSize;
+    if (sizeof(NVRAM_VARIABLE) + NameSize + VariableSize + sizeof(uint8_t) > NVRAM_STORE_SIZE - Offset)
+        return RETURN_OUT_OF_RESOURCES;
+
+    Variable = NvramIndexLookup(VariableName);
+    if (Variable != NULL)
+        Variable->Flag = FLAG_INVALID;
+
+    Variable = (NVRAM_VARIABLE *)&gNvramStore[Offset];
+    memcpy(Variable->signature, NVRAM_SIGNATURE, sizeof(Variable->signature));
+    Variable->VariableNameSize = NameSize;
+    Variable->VariableAttribute = VariableAttribute;
+    Variable->VariableLength = VariableSize;
+    Variable->Flag = FLAG_VALID;
+    memcpy(Variable + 1, VariableName, NameSize);
+    Payload = (uint8_t *)(Variable + 1) + NameSize;
+    if (VariableSize)
+        memcpy(Payload, Data, VariableSize);
+    Payload[VariableSize] = CheckVariableIntegrity((uint8_t *)Variable,
+            NVRAM_VARIABLE_TOTAL_SIZE(Variable) - sizeof(uint8_t));
+    Header->DataStoreSize += NVRAM_VARIABLE_TOTAL_SIZE(Variable);
+
+    return NvramIndexInsert(Offset);
+}
+
 /**
   Function to Get read and write count based on port type
   @param  PortType: type of the port
@@ -63,6 +327,24 @@ RETURN_STATUS GetNvramStore(uint8_t *NvramStore, uint32_t Position)
 **/
 RETURN_STATUS GetVariableData (char *VariableName, uint8_t *VariableAttribute, uint32_t *VariableSize, uint8_t* Data)
 {
+    NVRAM_VARIABLE  *Variable;
+    uint8_t         *Payload;
+
+    // Hash probe and a single bounded copy, anything unusual goes through the store scan
+    if (gNvramIndexValid && VariableName != NULL && VariableSize != NULL && Data != NULL) {
+        Variable = NvramIndexLookup(VariableName);
+        if (Variable != NULL && Variable->Flag == FLAG_VALID && *VariableSize >= Variable->VariableLength) {
+            Payload = (uint8_t *)(Variable + 1) + Variable->VariableNameSize;
+            if (Payload[Variable->VariableLength] ==
+                CheckVariableIntegrity((uint8_t *)Variable, NVRAM_VARIABLE_TOTAL_SIZE(Variable) - sizeof(uint8_t))) {
+                memcpy(Data, Payload, Variable->VariableLength);
+                *VariableSize = Variable->VariableLength;
+                if (VariableAttribute != NULL)
+                    *VariableAttribute = Variable->VariableAttribute;
+                return RETURN_SUCCESS;
+            }
+        }
+    }
 
     return GetVariableDataWrapper(VariableName,VariableAttribute,VariableSize, Data);
 }
@@ -85,7 +367,17 @@ RETURN_STATUS GetVariableData (char *VariableName, uint8_t *VariableAttribute, u
 **/
 RETURN_STATUS SetVariableData (char *VariableName, uint8_t VariableAttribute, uint32_t VariableSize, uint8_t* Data)
 {
-	return SetVariableDataWrapper (VariableName, VariableAttribute,VariableSize, Data);
+	RETURN_STATUS Status;
+
+	Status = SetVariableDataWrapper (VariableName, VariableAttribute,VariableSize, Data);
+	if (gNvramIndexValid) {
+		// Only the written variable moves, unless the store had to be compacted for it
+		if (Status != RETURN_SUCCESS)
+			gNvramIndexValid = FALSE;
+		else if (NvramIndexUpdate(VariableName, VariableAttribute, VariableSize, Data) != RETURN_SUCCESS)
+			NvramIndexBuild();
+	}
+	return Status;
 }
 
 /**
@@ -192,7 +484,12 @@ uint8_t CalculateNvramCheckSum()
 **/
 RETURN_STATUS BeginGarbageCollection()
 {
-      return BeginGarbageCollectionWrapper();
+      RETURN_STATUS Status;
+
+      // Variables move during compaction
+      Status = BeginGarbageCollectionWrapper();
+      NvramIndexBuild();
+      return Status;
 }
 
 /**
@@ -209,22 +506,11 @@ RETURN_STATUS BeginGarbageCollection()
 uint8_t CheckVariableIntegrity (uint8_t *Data,uint32_t Length)
 {
    uint8_t Crc = 0x00;
-   uint8_t Extract = 0;
-   uint8_t Sum = 0;
    uint32_t i = 0;
-   uint8_t j = 0;
-   
+
    for(i=0;i<Length;i++)
    {
-      Extract = *Data;
-      for ( j = 8; j; j--) 
-      {
-         Sum = (Crc ^ Extract) & 0x01;
-         Crc >>= 1;
-         if (Sum)
-            Crc ^= 0x8C;
-         Extract >>= 1;
-      }
+      Crc = NvramCrc8Table[Crc ^ *Data];
       Data++;
    }
    return Crc;
@@ -244,10 +530,11 @@ uint8_t CheckVariableIntegrity (uint8_t *Data,uint32_t Length)
 RETURN_STATUS NvramInit()
 {
     NVRAM_HEADER    HeaderData = {0};
-    uint8_t         NVRAMBuffer[4096] = {0};
+    uint8_t         *NVRAMBuffer = &gNvramStore[0];
     EFI_GUID        NvramGuid = NVRAM_GUID;
     RETURN_STATUS   Status = RETURN_SUCCESS;
     
+    gNvramIndexValid = FALSE;
     Status = GetNvramStore(&NVRAMBuffer[0], 0);
     if(Status != RETURN_SUCCESS)
         return RETURN_OUT_OF_RESOURCES;
@@ -265,9 +552,10 @@ RETURN_STATUS NvramInit()
         HeaderData.CheckSum = CheckVariableIntegrity(&NVRAMBuffer[0],sizeof(HeaderData)-sizeof(HeaderData.CheckSum));
         memcpy(&NVRAMBuffer[0],&HeaderData,sizeof(HeaderData));
         Status = SetNvramStore(&NVRAMBuffer[0], 0 ,sizeof(HeaderData));
-        if(Status == RETURN_SUCCESS)
+        if(Status == RETURN_SUCCESS) {
             TRACE("NVRAM Initialization done\r\n");
-        else
+            NvramIndexBuild();
+        } else
             TRACE("NVRAM Initialization failed\r\n");
     } else {
 		TRACE("NVRAM Initialization done\r\n");
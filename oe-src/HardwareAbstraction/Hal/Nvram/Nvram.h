@@ -37,6 +37,15 @@ extern "C" {
 
 #define SET_DIFF_SIZE 0x2
 
+#define NVRAM_STORE_SIZE    4096
+#define NVRAM_INDEX_SIZE    64      // Name hash index slots, open addressing
+
+///
+/// Bytes taken by a variable in the store: header, name, data and the trailing CRC-8.
+///
+#define NVRAM_VARIABLE_TOTAL_SIZE(Var) \
+    (sizeof(NVRAM_VARIABLE) + (Var)->VariableNameSize + (Var)->VariableLength + sizeof(uint8_t))
+
 ///
 /// EFI_GUID .
 /// This structure indicates the GUID data format.
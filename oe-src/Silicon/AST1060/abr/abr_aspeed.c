@@ -1,5 +1,8 @@
 #include "abr_aspeed.h"
 #include <init.h>
+#include <zephyr.h>
+
+static bool abr_switch_pending;
 
 void print_abr_wdt_info(void)
 {
@@ -55,3 +58,103 @@ void disable_watchdog(void)
 	sys_write32(reg_val, ASPEED_FMC_WDT2_CTRL);
 	printk("\r\n The WDT is disabled.\n");
 }
+
+/*
+ * RoT A/B slot switching.
+ *
+ * With ABR strapped, the FMC WDT2 is armed by hardware on every reset and, if it expires, the
+ * boot ROM restarts from the alternate slot and the FMC decodes that slot at offset 0.  On a
+ * board whose active and recovery partitions are the two slots, the running image therefore
+ * always sits in the active partition and the other slot in the recovery partition.  Callers
+ * check that with abr_alternate_offset() and abr_remapped_length() before relying on it, as the
+ * swap also moves any other partition inside the remapped range.
+ * A RoT update writes the new image once into the recovery partition
+ * and lets WDT2 expire to boot it; a slot that never reaches abr_boot_confirm() falls back to the
+ * previous one when WDT2 expires again.
+ */
+bool abr_is_enabled(void)
+{
+	return (sys_read32(HW_STRAP2_SCU510) & BIT(11)) ? true : false; // OTPSTRAP[43]
+}
+
+/* Boot flash size from OTPSTRAP[47:45], 0 if the size is not strapped */
+uint32_t abr_flash_size(void)
+{
+	uint32_t size = (sys_read32(HW_STRAP2_SCU510) >> 13) & 0x7;
+
+	return size ? (BIT(size) * ABR_FLASH_SIZE_UNIT) : 0;
+}
+
+/*
+ * Offset of the alternate slot for the strapped layout (OTPSTRAP[3]), 0 if it can't be derived.
+ * With the 1/2 layout the two halves of the flash are swapped when booting from the alternate
+ * source.  With the 1/3 layout the first two thirds are swapped and the last third is decoded at
+ * the same offset from both slots.
+ */
+uint32_t abr_alternate_offset(void)
+{
+	uint32_t size = abr_flash_size();
+	uint32_t alternate;
+
+	if (!size)
+		return 0;
+
+	if (sys_read32(HW_STRAP1_SCU500) & BIT(3))
+		alternate = size / 3;
+	else
+		alternate = size / 2;
+
+	// Slots have to start on a sector boundary
+	if (alternate & (ABR_SECTOR_SIZE - 1))
+		return 0;
+
+	return alternate;
+}
+
+/* Length of the flash range whose decoding depends on the boot source */
+uint32_t abr_remapped_length(void)
+{
+	return abr_alternate_offset() * 2;
+}
+
+bool abr_booted_from_alternate(void)
+{
+	return (sys_read32(ASPEED_FMC_WDT2_CTRL) & BIT(4)) ? true : false;
+}
+
+/* Flip to the other slot on the next reboot instead of a plain reset */
+void abr_request_switch(void)
+{
+	abr_switch_pending = true;
+}
+
+bool abr_switch_requested(void)
+{
+	return abr_switch_pending;
+}
+
+void abr_switch_boot_source(void)
+{
+	uint32_t reg_val;
+
+	printk("\r\n Switching boot flash source.\n");
+
+	/* Shortest reload, the watchdog expires right away and the boot ROM toggles the source */
+	sys_write32(1, ASPEED_FMC_WDT2_RELOAD);
+	sys_write32(FMC_WDT2_RESTART_MAGIC, ASPEED_FMC_WDT2_RESTART);
+	reg_val = sys_read32(ASPEED_FMC_WDT2_CTRL);
+	reg_val |= BIT(0);
+	sys_write32(reg_val, ASPEED_FMC_WDT2_CTRL);
+
+	while (1)
+		k_cpu_idle();
+}
+
+/* The running slot booted to T0, keep it */
+void abr_boot_confirm(void)
+{
+	if (!abr_is_enabled() || !(sys_read32(ASPEED_FMC_WDT2_CTRL) & BIT(0)))
+		return;
+
+	disable_watchdog();
+}
@@ -1,3 +1,24 @@
 #define HW_STRAP1_SCU500                0x7e6e2500
 #define HW_STRAP2_SCU510                0x7e6e2510
-#define ASPEED_FMC_WDT2_CTRL    0x7e620064
\ No newline at end of file
+#define ASPEED_FMC_WDT2_CTRL    0x7e620064
+#define ASPEED_FMC_WDT2_RELOAD  0x7e620068
+#define ASPEED_FMC_WDT2_RESTART 0x7e62006c
+#define FMC_WDT2_RESTART_MAGIC  0x4755
+#define ABR_FLASH_SIZE_UNIT     0x80000
+#define ABR_SECTOR_SIZE         0x1000
+
+#include <stdbool.h>
+#include <stdint.h>
+
+void print_abr_wdt_info(void);
+void clear_source_select_indicator(void);
+void disable_watchdog(void);
+bool abr_is_enabled(void);
+uint32_t abr_flash_size(void);
+uint32_t abr_alternate_offset(void);
+uint32_t abr_remapped_length(void);
+bool abr_booted_from_alternate(void);
+void abr_request_switch(void);
+bool abr_switch_requested(void);
+void abr_switch_boot_source(void);
+void abr_boot_confirm(void);
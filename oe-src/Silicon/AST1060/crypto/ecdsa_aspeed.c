@@ -5,40 +5,82 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <crypto/ecdsa_structs.h>
 #include <crypto/ecdsa.h>
 #include <zephyr.h>
+#include "ecdsa_aspeed.h"
+#include "rsa_aspeed.h"
 
-int aspeed_ecdsa_verify_middlelayer(uint8_t *public_key_x, uint8_t *public_key_y,
-				    const uint8_t *digest, uint8_t *signature_r,
+#ifdef CONFIG_ECDSA_ASPEED
+static const struct device *ecdsa_dev;
+#endif
+
+/**
+ * Verify an ECDSA signature with the hardware engine.
+ *
+ * @param public_key_x Public key X coordinate, big endian.
+ * @param public_key_y Public key Y coordinate, big endian.
+ * @param key_length Length of one coordinate, 32 for P-256 or 48 for P-384.
+ * @param digest The digest that was signed.
+ * @param digest_length Length of the digest.
+ * @param signature_r Signature R, key_length bytes.
+ * @param signature_s Signature S, key_length bytes.
+ *
+ * @return 0 if the signature is valid, ASPEED_ECDSA_UNAVAILABLE if the engine cannot take the
+ * request and the caller should verify in software, or another error code if the signature
+ * does not match.
+ */
+int aspeed_ecdsa_verify_middlelayer(uint8_t *public_key_x, uint8_t *public_key_y, size_t key_length,
+				    const uint8_t *digest, size_t digest_length, uint8_t *signature_r,
 				    uint8_t *signature_s)
 {
+#ifdef CONFIG_ECDSA_ASPEED
 	int status = 0;
-	const struct device *dev = device_get_binding(ECDSA_DRV_NAME);
 	struct ecdsa_ctx ini;
 	struct ecdsa_pkt pkt;
 	struct ecdsa_key ek;
 
-	ek.curve_id = ECC_CURVE_NIST_P256;
+	if (key_length == 32)
+		ek.curve_id = ECC_CURVE_NIST_P256;
+	else if (key_length == 48)
+		ek.curve_id = ECC_CURVE_NIST_P384;
+	else
+		return ASPEED_ECDSA_UNAVAILABLE;
+
+	if (ecdsa_dev == NULL) {
+		ecdsa_dev = device_get_binding(ECDSA_DRV_NAME);
+		if (ecdsa_dev == NULL)
+			return ASPEED_ECDSA_UNAVAILABLE;
+	}
+
+	if (k_mutex_lock(&acry_engine_lock, K_NO_WAIT) != 0)
+		return ASPEED_ECDSA_UNAVAILABLE;
+
+	// The ECDSA operands overwrite the RSA key loaded in the ACRY engine
+	rsa_session_close();
+
 	ek.qx = public_key_x;
 	ek.qy = public_key_y;
 	pkt.m = digest;
 	pkt.r = signature_r;
 	pkt.s = signature_s;
-	pkt.m_len = 32;
-	pkt.r_len = 32;
-	pkt.s_len = 32;
-	status = ecdsa_begin_session(dev, &ini, &ek);
+	pkt.m_len = digest_length;
+	pkt.r_len = key_length;
+	pkt.s_len = key_length;
+	status = ecdsa_begin_session(ecdsa_dev, &ini, &ek);
 	if (status) {
-		printk("ecdsa_begin_session fail: %d\r\n", status);
+		// Curve not supported by this engine, or the engine is in use
+		k_mutex_unlock(&acry_engine_lock);
+		return ASPEED_ECDSA_UNAVAILABLE;
 	}
+
 	status = ecdsa_verify(&ini, &pkt);
-	if (status) {
-		printk("Fail\r\n");
-	} else {
-		printk("Success\r\n");
-	}
-	ecdsa_free_session(dev, &ini);
+	ecdsa_free_session(ecdsa_dev, &ini);
+	k_mutex_unlock(&acry_engine_lock);
 
 	return status;
+#else
+	return ASPEED_ECDSA_UNAVAILABLE;
+#endif
 }
@@ -1,8 +1,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <crypto/ecdsa_structs.h>
 #include <crypto/ecdsa.h>
 #include <zephyr.h>
 
-int aspeed_ecdsa_verify_middlelayer(uint8_t *public_key_x, uint8_t *public_key_y, const uint8_t *digest, uint8_t *signature_r, uint8_t *signature_s);
\ No newline at end of file
+/* The engine cannot take the request, verify in software instead */
+#define ASPEED_ECDSA_UNAVAILABLE	(-ENODEV)
+
+int aspeed_ecdsa_verify_middlelayer(uint8_t *public_key_x, uint8_t *public_key_y, size_t key_length,
+				    const uint8_t *digest, size_t digest_length, uint8_t *signature_r,
+				    uint8_t *signature_s);
@@ -12,6 +12,18 @@
 #include "hash_aspeed.h"
 
 static struct hash_params hashParams;   // hash internal parameters
+static const struct device *hashDev;    // hash engine driver, bound on first use
+
+/**
+ * @brief Get the hash engine driver, the binding lookup is only done once.
+ */
+static const struct device *hash_engine_device(void)
+{
+	if (hashDev == NULL)
+		hashDev = device_get_binding(HASH_DRV_NAME);
+
+	return hashDev;
+}
 
 /**
  * @brief Calculate a hash on a complete set of data.
@@ -29,7 +41,7 @@ int hash_engine_sha_calculate(enum hash_algo algo, const uint8_t *data, size_t l
 	const struct device *dev;       // hash engine driver info
 	int ret;
 
-	dev = device_get_binding(HASH_DRV_NAME);        // retrieves hash driver device info
+	dev = hash_engine_device();                     // retrieves hash driver device info
 
 	hashParams.pkt.in_buf = (uint8_t *)data;        // plaint text info
 	hashParams.pkt.in_len = length;                 // plaint text size
@@ -74,7 +86,7 @@ int hash_engine_start(enum hash_algo algo)
 
 	memset(&hashParams, 0, sizeof(hashParams));             // clear all the hash internal parameters
 
-	dev = device_get_binding(HASH_DRV_NAME);                // retrieves hash driver device info
+	dev = hash_engine_device();                             // retrieves hash driver device info
 
 	ret = hash_begin_session(dev, &hashParams.ctx, algo);   // initializes hash engine
 
@@ -116,7 +128,7 @@ int hash_engine_update(const uint8_t *data, size_t length)
  */
 int hash_engine_finish(uint8_t *hash, size_t hash_length)
 {
-	const struct device *dev = device_get_binding(HASH_DRV_NAME);   // retrieves hash driver device info
+	const struct device *dev = hash_engine_device();                // retrieves hash driver device info
 	int ret;
 
 	hashParams.pkt.out_buf = hash,                          // hash value and this will updated by hash engine
@@ -138,7 +150,7 @@ int hash_engine_finish(uint8_t *hash, size_t hash_length)
  */
 void hash_engine_cancel(void)
 {
-	const struct device *dev = device_get_binding(HASH_DRV_NAME);   // retrieves hash driver device info
+	const struct device *dev = hash_engine_device();                // retrieves hash driver device info
 
 	hashParams.sessionReady = 0;                                    // clear as hash engine session as expired, this should initialize again
 
@@ -1,30 +1,141 @@
 #include <zephyr.h>
 #include <sys/printk.h>
 #include <string.h>
+#include <errno.h>
+#include <stdbool.h>
 #include <crypto/rsa_structs.h>
 #include <crypto/rsa.h>
 #include "rsa_aspeed.h"
 
+#define RSA_KEY_BYTES(bits)	(((bits) + 7) / 8)
+
+/*
+ * A single RSA session is kept open between calls so back-to-back signature checks with the same
+ * public key (e.g. every signed region of a Cerberus PFM) don't have to look up the driver and
+ * reload the key into the engine each time.  The key material is copied so the session does not
+ * depend on the lifetime of the caller's buffers.  The ECDSA driver loads its own operands into the
+ * same ACRY engine, so the session is only used under acry_engine_lock and ECDSA closes it first.
+ */
+K_MUTEX_DEFINE(acry_engine_lock);
+
+static const struct device *rsa_dev;
+static struct rsa_ctx rsa_session;
+static struct rsa_key rsa_session_key;
+static uint8_t rsa_session_m[RSA_SESSION_MAX_BYTES];
+static uint8_t rsa_session_e[RSA_SESSION_MAX_BYTES];
+static uint8_t rsa_session_d[RSA_SESSION_MAX_BYTES];
+static bool rsa_session_open;
+static uint8_t rsa_plain_text[RSA_SESSION_MAX_BYTES];
+
+static bool rsa_key_field_equal(const char *a, const char *b, int bits)
+{
+	if (bits == 0)
+		return true;
+
+	if ((a == NULL) || (b == NULL))
+		return a == b;
+
+	return memcmp(a, b, RSA_KEY_BYTES(bits)) == 0;
+}
+
+static bool rsa_session_key_equal(const struct rsa_key *key)
+{
+	return (key->m_bits == rsa_session_key.m_bits) &&
+	       (key->e_bits == rsa_session_key.e_bits) &&
+	       (key->d_bits == rsa_session_key.d_bits) &&
+	       rsa_key_field_equal(key->m, rsa_session_key.m, key->m_bits) &&
+	       rsa_key_field_equal(key->e, rsa_session_key.e, key->e_bits) &&
+	       rsa_key_field_equal(key->d, rsa_session_key.d, key->d_bits);
+}
+
+static char *rsa_session_copy(uint8_t *dst, const char *src, int bits)
+{
+	if ((src == NULL) || (bits == 0))
+		return NULL;
+
+	memcpy(dst, src, RSA_KEY_BYTES(bits));
+
+	return (char *)dst;
+}
+
+/**
+ * Get an RSA session for a key, reusing the open session when the key has not changed.
+ *
+ * @param key The key to load into the RSA engine.
+ *
+ * @return 0 if the session is ready or an error code.
+ */
+static int rsa_session_get(const struct rsa_key *key)
+{
+	int ret;
+
+	if (rsa_dev == NULL) {
+		rsa_dev = device_get_binding(RSA_DRV_NAME);
+		if (rsa_dev == NULL)
+			return -ENODEV;
+	}
+
+	if (rsa_session_open && rsa_session_key_equal(key))
+		return 0;
+
+	rsa_session_close();
+
+	if ((RSA_KEY_BYTES(key->m_bits) > RSA_SESSION_MAX_BYTES) ||
+	    (RSA_KEY_BYTES(key->e_bits) > RSA_SESSION_MAX_BYTES) ||
+	    (RSA_KEY_BYTES(key->d_bits) > RSA_SESSION_MAX_BYTES))
+		return -EINVAL;
+
+	rsa_session_key.m = rsa_session_copy(rsa_session_m, key->m, key->m_bits);
+	rsa_session_key.e = rsa_session_copy(rsa_session_e, key->e, key->e_bits);
+	rsa_session_key.d = rsa_session_copy(rsa_session_d, key->d, key->d_bits);
+	rsa_session_key.m_bits = key->m_bits;
+	rsa_session_key.e_bits = key->e_bits;
+	rsa_session_key.d_bits = key->d_bits;
+
+	ret = rsa_begin_session(rsa_dev, &rsa_session, &rsa_session_key);
+	if (ret) {
+		printk("rsa_begin_session fail: %d", ret);
+		return ret;
+	}
+
+	rsa_session_open = true;
+
+	return 0;
+}
+
+/**
+ * Release the cached RSA session, if any.
+ */
+void rsa_session_close(void)
+{
+	k_mutex_lock(&acry_engine_lock, K_FOREVER);
+
+	if (rsa_session_open) {
+		rsa_free_session(rsa_dev, &rsa_session);
+		rsa_session_open = false;
+		memset(rsa_session_d, 0, sizeof(rsa_session_d));
+	}
+
+	k_mutex_unlock(&acry_engine_lock);
+}
+
 int decrypt_aspeed(const struct rsa_key *key, const uint8_t *encrypted, size_t in_length, uint8_t *decrypted, size_t out_length)
 {
-	const struct device *dev = device_get_binding(RSA_DRV_NAME);
-	struct rsa_ctx ini;
 	struct rsa_pkt pkt;
-	struct rsa_key *rk;
 	int ret;
-	int j;
 
-	rk = key;
 	pkt.in_buf = encrypted;
 	pkt.in_len = in_length;
 	pkt.out_buf = decrypted;
 	pkt.out_buf_max = out_length;
-	ret = rsa_begin_session(dev, &ini, rk);
-	if (ret)
-		printk("rsa_begin_session fail: %d", ret);
+	k_mutex_lock(&acry_engine_lock, K_FOREVER);
+	ret = rsa_session_get(key);
+	if (ret == 0)
+		ret = rsa_decrypt(&rsa_session, &pkt);
 
-	rsa_decrypt(&ini, &pkt);
-	rsa_free_session(dev, &ini);
+	// Don't keep private key material loaded
+	rsa_session_close();
+	k_mutex_unlock(&acry_engine_lock);
 
 	return ret;
 }
@@ -43,57 +154,35 @@ int decrypt_aspeed(const struct rsa_key *key, const uint8_t *encrypted, size_t i
  */
 int sig_verify_aspeed(const struct rsa_key *key, const uint8_t *signature, int sig_length, const uint8_t *match, size_t match_length)
 {
-	const struct device *dev = device_get_binding(RSA_DRV_NAME);
-	struct rsa_ctx ini;
 	struct rsa_pkt pkt;
-	char plain_text[sig_length];
 	int ret;
 
+	if ((sig_length <= 0) || (sig_length > sizeof(rsa_plain_text)) || (match_length > sig_length))
+		return -EINVAL;
+
 	pkt.in_buf = signature;
 	pkt.in_len = sig_length;
-	pkt.out_buf = plain_text;// match;
+	pkt.out_buf = rsa_plain_text;
 	pkt.out_buf_max = sig_length;
-	memset(plain_text, 0, sig_length);
-	ret = rsa_begin_session(dev, &ini, key);
-
-	if (ret)
-		printk("rsa_begin_session fail: %d", ret);
-
-	rsa_verify(&ini, &pkt);// decrypt signature
+	memset(rsa_plain_text, 0, sig_length);
+	k_mutex_lock(&acry_engine_lock, K_FOREVER);
+	ret = rsa_session_get(key);
+	if (ret == 0)
+		ret = rsa_verify(&rsa_session, &pkt);// decrypt signature
+
+	if (ret) {
+		// The engine state is unknown after a failed operation, load the key again next time
+		rsa_session_close();
+		k_mutex_unlock(&acry_engine_lock);
+		return ret;
+	}
 
-	rsa_free_session(dev, &ini);
+	k_mutex_unlock(&acry_engine_lock);
 
-	ret = memcmp(plain_text + pkt.out_len - match_length, match, match_length);
-	// if (ret != 0)
-	// {
-	//      printk("verify Fail:\n");
-	//      printk("Result Text:");
-	//      for(int i = 0; i < sig_length; i++){
-	//              if(i % 16 == 0)
-	//                      printk("\n");
-	//              printk("%2x,", plain_text[i]);
-	//      }
-	//      printk("\n");
-	//      printk("Signature:");
-	//      for(int i = 0; i < sig_length; i++){
-	//              if(i % 16 ==0)
-	//                      printk("\n");
-	//              printk("%2x,", *(signature+i));
-	//      }
-	//      printk("\n");
-
-	//      printk("Hash:\n");
-	//      for(int i = 0; i < match_length; i++){
-	//              if(i % 16 == 0)
-	//                      printk("\n");
-	//              printk("%x,", *(match+i));
-	//      }
-	//      printk("\n");
-	// }else{
-	//      printk("Verification Successful \n");
-	// }
+	if ((pkt.out_len < match_length) || (pkt.out_len > sig_length))
+		return -EINVAL;
 
-	return ret;
+	return memcmp(rsa_plain_text + pkt.out_len - match_length, match, match_length);
 }
 
 #if ZEPHYR_RSA_API_MIDLEYER_TEST_SUPPORT
@@ -313,6 +402,7 @@ static int RsaDecryptTest(void)
 	int ret;
 
 	printk("RsaDecryptTest start:\n");
+	rsa_session_close();
 	rk = &RsaTD[0].k;
 	pkt.in_buf = RsaTD[0].p;
 	pkt.in_len = RsaTD[0].p_size;
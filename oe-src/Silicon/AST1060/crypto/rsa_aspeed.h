@@ -6,6 +6,7 @@
 #ifndef ZEPHYR_INCLUDE_RSA_API_MIDLEYER_H_
 #define ZEPHYR_INCLUDE_RSA_API_MIDLEYER_H_
 
+#include <kernel.h>
 #include <crypto/rsa_structs.h>
 
 #define ZEPHYR_RSA_API_MIDLEYER_TEST_SUPPORT 1  // non-zero for support rsa functions testing
@@ -16,11 +17,17 @@
 #endif
 #endif
 
+#define RSA_SESSION_MAX_BYTES	512	// RSA 4096
+
+/* RSA and ECDSA both run on the ACRY engine, hold this lock around any use of it */
+extern struct k_mutex acry_engine_lock;
+
 #if ZEPHYR_RSA_API_MIDLEYER_TEST_SUPPORT
 void rsa_engine_function_test(void);    // rsa functions testing
 #endif
 
 int decrypt_aspeed(const struct rsa_key *key, const uint8_t *encrypted, size_t in_length, uint8_t *decrypted, size_t out_length);
 int sig_verify_aspeed(const struct rsa_key *key, const uint8_t *signature, int sig_length, const uint8_t *match, size_t match_length);
+void rsa_session_close(void);
 int rsa_sig_verify_test(void);
 #endif  /* ZEPHYR_INCLUDE_RSA_API_MIDLEYER_H_ */
@@ -11,6 +11,7 @@
 #include <sys/util.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <zephyr.h>
 #include <flash_map.h>
 // #include <flash_master.h>
@@ -49,7 +50,6 @@ int BMC_PCH_SPI_Command(struct pspi_flash *flash, struct pflash_xfer *xfer)
 	int AdrOffset = 0, Datalen = 0;
 	uint32_t FlashSize = 0;
 	int ret = 0;
-	char buf[4096];
 	uint32_t page_sz = 0;
 	uint32_t sector_sz = 0;
 
@@ -78,16 +78,13 @@ int BMC_PCH_SPI_Command(struct pspi_flash *flash, struct pflash_xfer *xfer)
 		return page_sz;
 		break;
 	case MIDLEY_FLASH_CMD_READ:
-		ret = flash_read(flash_device, AdrOffset, buf, Datalen);
-		// Data_dump_buf(buf,Datalen);
-		if (xfer->data != NULL) {
-			memcpy(xfer->data, buf, Datalen);
-		}
+		if (xfer->data == NULL)
+			return -EINVAL;
+		ret = flash_read(flash_device, AdrOffset, xfer->data, Datalen);
+		// Data_dump_buf(xfer->data,Datalen);
 		break;
 	case MIDLEY_FLASH_CMD_PP:        // Flash Write
-		memset(buf, 0xff, Datalen);
-		memcpy(buf, xfer->data, Datalen);
-		ret = flash_write(flash_device, AdrOffset, buf, Datalen);
+		ret = flash_write(flash_device, AdrOffset, xfer->data, Datalen);
 		break;
 	case MIDLEY_FLASH_CMD_4K_ERASE:
 		sector_sz = flash_get_write_block_size(flash_device);
@@ -123,7 +120,6 @@ int FMC_SPI_Command(struct pspi_flash *flash, struct pflash_xfer *xfer)
 	uint32_t sector_sz = 0;
 	int AdrOffset = 0;
 	int Datalen = 0;
-	char buf[4096];
 	int err, ret = 0;
 
 	flash_device = device_get_binding(Flash_Devices_List[ROT_SPI]);
@@ -164,16 +160,13 @@ int FMC_SPI_Command(struct pspi_flash *flash, struct pflash_xfer *xfer)
 		break;
 
 	case MIDLEY_FLASH_CMD_READ:
-		ret = flash_area_read(partition_device, AdrOffset, buf, Datalen);
-		if (xfer->data != NULL) {
-			memcpy(xfer->data, buf, Datalen);
-		}
+		if (xfer->data == NULL)
+			return -EINVAL;
+		ret = flash_area_read(partition_device, AdrOffset, xfer->data, Datalen);
 		break;
 
 	case MIDLEY_FLASH_CMD_PP:        // Flash Write
-		memset(buf, 0xff, Datalen);
-		memcpy(buf, xfer->data, Datalen);
-		ret = flash_area_write(partition_device, AdrOffset, buf, Datalen);
+		ret = flash_area_write(partition_device, AdrOffset, xfer->data, Datalen);
 		break;
 
 	case MIDLEY_FLASH_CMD_4K_ERASE:
@@ -212,7 +205,6 @@ int SPI_Command_Xfer(struct pspi_flash *flash, struct pflash_xfer *xfer)
 	uint32_t sector_sz = 0;
 	uint32_t page_sz = 0;
 	int ret = 0, i = 0;
-	char buf[4096];
 	int AdrOffset = 0, Datalen = 0;
 	struct device *dev;
 
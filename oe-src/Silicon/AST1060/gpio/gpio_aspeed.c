@@ -40,118 +40,129 @@ static void GPIO_dump_buf(uint8_t *buf, uint32_t len)
 	printk("\n");
 }
 
-int BMCBootHold(void)
-{
-	const struct device *gpio_dev = NULL;
-	const struct device *dev_m = NULL;
-
-	dev_m = device_get_binding(BMC_SPI_MONITOR);
-	spim_rst_flash(dev_m, 1000);
-	spim_passthrough_config(dev_m, 0, false);
-	spim_ext_mux_config(dev_m, SPIM_MASTER_MODE);
-	/* GPIOM5 */
-	gpio_dev = device_get_binding("GPIO0_M_P");
-
-	if (gpio_dev == NULL) {
-		printk("[%d]Fail to get GPIO0_M_P", __LINE__);
-		return -1;
-	}
+/*
+ * Host reset hold/release sequencing.
+ *
+ * The SPI monitor mux is switched synchronously so the RoT owns (or hands back) the flash as soon
+ * as the call returns.  The reset line then needs a settle time before and after it is driven;
+ * that part runs from delayable work so the caller can carry on with engine init, mailbox setup
+ * or verification of the other host while the line settles.  A new sequence on the same host
+ * waits for the previous one to finish, so hold and release are always applied in order.
+ */
+enum {
+	HOST_RESET_IDLE = 0,
+	HOST_RESET_CONFIGURED,
+	HOST_RESET_DRIVEN,
+};
 
-	gpio_pin_configure(gpio_dev, BMC_SRST, GPIO_OUTPUT);
+struct host_reset_seq {
+	struct k_work_delayable work;
+	struct k_sem done;
+	const struct device *gpio_dev;
+	uint8_t pin;
+	uint8_t level;
+	uint8_t step;
+	uint32_t settle_ms;
+	bool initialized;
+};
 
-	k_busy_wait(10000); /* 10ms */
+static struct host_reset_seq bmc_reset_seq = { .pin = BMC_SRST };
+static struct host_reset_seq pch_reset_seq = { .pin = CPU0_RST };
 
-	gpio_pin_set(gpio_dev, BMC_SRST, 0);
+static void host_reset_work_handler(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct host_reset_seq *seq = CONTAINER_OF(dwork, struct host_reset_seq, work);
+
+	switch (seq->step) {
+	case HOST_RESET_CONFIGURED:
+		gpio_pin_set(seq->gpio_dev, seq->pin, seq->level);
+		seq->step = HOST_RESET_DRIVEN;
+		k_work_schedule(dwork, K_MSEC(seq->settle_ms));
+		break;
+	case HOST_RESET_DRIVEN:
+		seq->step = HOST_RESET_IDLE;
+		k_sem_give(&seq->done);
+		break;
+	default:
+		break;
+	}
+}
 
-	k_busy_wait(10000); /* 10ms */
+static void host_reset_seq_init(struct host_reset_seq *seq)
+{
+	if (seq->initialized)
+		return;
 
-	return 0;
+	k_work_init_delayable(&seq->work, host_reset_work_handler);
+	k_sem_init(&seq->done, 1, 1);
+	seq->initialized = true;
 }
 
-int PCHBootHold(void)
+static int host_reset_start(struct host_reset_seq *seq, const char *spim, int mux_mode, uint8_t level,
+			    uint32_t settle_ms)
 {
-	const struct device *gpio_dev = NULL;
 	const struct device *dev_m = NULL;
 
-	dev_m = device_get_binding(PCH_SPI_MONITOR);
+	host_reset_seq_init(seq);
+	k_sem_take(&seq->done, K_FOREVER);
+
+	dev_m = device_get_binding(spim);
 	spim_rst_flash(dev_m, 1000);
 	spim_passthrough_config(dev_m, 0, false);
-	spim_ext_mux_config(dev_m, SPIM_MASTER_MODE);
+	spim_ext_mux_config(dev_m, mux_mode);
 
 	/* GPIOM5 */
-	gpio_dev = device_get_binding("GPIO0_M_P");
+	seq->gpio_dev = device_get_binding("GPIO0_M_P");
 
-	if (gpio_dev == NULL) {
+	if (seq->gpio_dev == NULL) {
 		printk("[%d]Fail to get GPIO0_M_P", __LINE__);
+		k_sem_give(&seq->done);
 		return -1;
 	}
 
-	gpio_pin_configure(gpio_dev, CPU0_RST, GPIO_OUTPUT);
-
-	k_busy_wait(10000); /* 10ms */
+	gpio_pin_configure(seq->gpio_dev, seq->pin, GPIO_OUTPUT);
 
-	gpio_pin_set(gpio_dev, CPU0_RST, 0);
-
-	k_busy_wait(10000); /* 10ms */
+	seq->level = level;
+	seq->settle_ms = settle_ms;
+	seq->step = HOST_RESET_CONFIGURED;
+	k_work_schedule(&seq->work, K_MSEC(settle_ms));
 
 	return 0;
 }
 
-int BMCBootRelease(void)
+static void host_reset_wait(struct host_reset_seq *seq)
 {
-	const struct device *gpio_dev = NULL;
-	const struct device *dev_m = NULL;
-
-	dev_m = device_get_binding(BMC_SPI_MONITOR);
-	spim_rst_flash(dev_m, 1000);
-	spim_passthrough_config(dev_m, 0, false);
-	spim_ext_mux_config(dev_m, SPIM_MONITOR_MODE);
-
-	/* GPIOM5 */
-	gpio_dev = device_get_binding("GPIO0_M_P");
-
-	if (gpio_dev == NULL) {
-		printk("[%d]Fail to get GPIO0_M_P", __LINE__);
-		return -1;
-	}
-
-	gpio_pin_configure(gpio_dev, BMC_SRST, GPIO_OUTPUT);
-
-	k_busy_wait(20000); /* 10ms */
+	host_reset_seq_init(seq);
+	k_sem_take(&seq->done, K_FOREVER);
+	k_sem_give(&seq->done);
+}
 
-	gpio_pin_set(gpio_dev, BMC_SRST, 1);
+int BMCBootHold(void)
+{
+	return host_reset_start(&bmc_reset_seq, BMC_SPI_MONITOR, SPIM_MASTER_MODE, 0, 10);
+}
 
-	k_busy_wait(20000); /* 10ms */
+int PCHBootHold(void)
+{
+	return host_reset_start(&pch_reset_seq, PCH_SPI_MONITOR, SPIM_MASTER_MODE, 0, 10);
+}
 
-	return 0;
+int BMCBootRelease(void)
+{
+	return host_reset_start(&bmc_reset_seq, BMC_SPI_MONITOR, SPIM_MONITOR_MODE, 1, 20);
 }
 
 int PCHBootRelease(void)
 {
-	const struct device *gpio_dev = NULL;
-	const struct device *dev_m = NULL;
-
-	dev_m = device_get_binding(PCH_SPI_MONITOR);
-	spim_rst_flash(dev_m, 1000);
-	spim_passthrough_config(dev_m, 0, false);
-	spim_ext_mux_config(dev_m, SPIM_MONITOR_MODE);
-
-	/* GPIOM5 */
-	gpio_dev = device_get_binding("GPIO0_M_P");
-
-	if (gpio_dev == NULL) {
-		printk("[%d]Fail to get GPIO0_M_P", __LINE__);
-		return -1;
-	}
-
-	gpio_pin_configure(gpio_dev, CPU0_RST, GPIO_OUTPUT);
-
-	k_busy_wait(10000); /* 10ms */
-
-	gpio_pin_set(gpio_dev, CPU0_RST, 1);
-
-	k_busy_wait(10000); /* 10ms */
-
-	return 0;
+	return host_reset_start(&pch_reset_seq, PCH_SPI_MONITOR, SPIM_MONITOR_MODE, 1, 10);
 }
 
+/**
+ * Wait for pending hold/release sequences on both hosts to reach their final reset state.
+ */
+void BootHoldReleaseWait(void)
+{
+	host_reset_wait(&bmc_reset_seq);
+	host_reset_wait(&pch_reset_seq);
+}
@@ -19,6 +19,13 @@ enum {
 	GPIO_APP_CMD_NOOP = 0x00,                               /**< No-op */
 };
 
+/* Hold/release only switch the SPI mux synchronously, the reset line settles in the background */
+int BMCBootHold(void);
+int PCHBootHold(void);
+int BMCBootRelease(void);
+int PCHBootRelease(void);
+void BootHoldReleaseWait(void);
+
 
 
 
@@ -326,6 +326,7 @@ int i2c_1060_slave_cb2_write_requested(struct i2c_slave_config *config)
 
 extern struct i2c_slave_callbacks i2c_1060_callbacks_bmc;
 extern struct i2c_slave_callbacks i2c_1060_callbacks_pch;
+extern const struct i2c_aspeed_slave_xfer_callbacks i2c_1060_xfer_callbacks_bmc;
 static struct i2c_slave_config slave_cfg_temp[2];
 
 int ast_i2c_slave_dev_init(const struct device *dev, uint8_t slave_addr)
@@ -342,11 +343,13 @@ int ast_i2c_slave_dev_init(const struct device *dev, uint8_t slave_addr)
 	{
 		data->slave_cfg = &slave_cfg_temp[0];
 		data->slave_cfg->callbacks = &i2c_1060_callbacks_bmc;
+		data->slave_xfer_cb = &i2c_1060_xfer_callbacks_bmc;
 	}
 	else if(!strcmp(dev->name, "I2C_2"))
 	{
 		data->slave_cfg = &slave_cfg_temp[1];
 		data->slave_cfg->callbacks = &i2c_1060_callbacks_pch;
+		data->slave_xfer_cb = NULL;
 	}
 
 	if (i2c_slave_register(dev, &slave_cfg)) {
@@ -30,6 +30,18 @@ struct i2c_aspeed_config {
 	enum i2c_xfer_mode mode;
 };
 
+#ifdef CONFIG_I2C_SLAVE
+/*
+ * Transaction level slave callbacks, must match the driver.  In DMA and buffer mode a whole
+ * master write is handed over in one write_done call and a read response is loaded in one
+ * read_buffer call, byte mode keeps using the per byte i2c_slave_callbacks.
+ */
+struct i2c_aspeed_slave_xfer_callbacks {
+	int (*write_done)(struct i2c_slave_config *config, uint8_t *buf, uint32_t len);
+	int (*read_buffer)(struct i2c_slave_config *config, uint8_t **buf, uint32_t *len);
+};
+#endif
+
 struct i2c_aspeed_data {
 	struct k_sem sync_sem;
 	struct k_mutex trans_mutex;
@@ -69,6 +81,7 @@ struct i2c_aspeed_data {
 #ifdef CONFIG_I2C_SLAVE
 	unsigned char slave_dma_buf[I2C_SLAVE_BUF_SIZE];
 	struct i2c_slave_config *slave_cfg;
+	const struct i2c_aspeed_slave_xfer_callbacks *slave_xfer_cb;
 #endif
 };
 
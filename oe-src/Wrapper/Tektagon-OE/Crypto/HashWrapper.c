@@ -10,13 +10,24 @@
 #include <crypto/hash.h>
 #include <crypto/hash_aspeed.h>
 
+static uint32_t hash_engine_bytes;	/**< Running count of bytes fed to the hash engine. */
+
+/**
+*	Function to get the number of bytes hashed since boot.
+*/
+uint32_t HashEngineBytesProcessed(void)
+{
+	return hash_engine_bytes;
+}
+
 /**
 *	Function to Hash Engine Calculate Sha256.
 */
 int HashEngineCalculateSha256 (const char *Data, size_t Length, char *Hash, size_t HashLength)
 {
 	enum hash_algo shaAlgo = HASH_SHA256;
-	
+
+	hash_engine_bytes += Length;
 	return hash_engine_sha_calculate(shaAlgo, Data, Length, Hash, HashLength);
 }
 
@@ -37,6 +48,7 @@ int HashEngineCalculateSha384 (const char *Data, size_t Length, char *Hash, size
 {
 	enum hash_algo shaAlgo = HASH_SHA384;
 
+	hash_engine_bytes += Length;
     return hash_engine_sha_calculate(shaAlgo, Data, Length, Hash, HashLength);
 }
 /**
@@ -53,6 +65,7 @@ int HashEngineStartSha384(void)
 */
 int HashEngineUpdate (const char *Data, size_t Length)
 {
+	hash_engine_bytes += Length;
 	return hash_engine_update(Data, Length);
 }
 
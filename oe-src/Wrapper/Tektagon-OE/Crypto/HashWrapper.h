@@ -14,6 +14,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <crypto/hash_aspeed.h>
 int HashEngineCalculateSha256 (const char *Data, size_t Length, char *Hash, size_t HashLength);
 int HashEngineStartSha256(void);
 int HashEngineCalculateSha384 (const char *Data, size_t Length, char *Hash, size_t HashLength);
@@ -21,5 +23,6 @@ int HashEngineStartSha384(void);
 int HashEngineUpdate (const char *Data, size_t Length);
 int HashEngineFinish (char *Hash, size_t HashLength);
 void HashEngineCancel(void);
+uint32_t HashEngineBytesProcessed(void);
 
 #endif /* HASH_WRAPPER_H_ */
@@ -23,6 +23,19 @@
 #include <flash/flash_common.h>
 #include "flash/flash_logging.h"
 
+static atomic_t spi_flash_transferred_bytes;	/**< Running count of bytes read from or written to SPI, updated from several threads. */
+
+/**
+ * Get the number of bytes moved over SPI since boot.  The counter wraps at 4GB; callers that need
+ * per-phase figures should take the difference between two samples.
+ *
+ * @return The running count of bytes read from or written to any SPI flash device.
+ */
+uint32_t Wrapper_spi_flash_transferred_bytes (void)
+{
+	return (uint32_t) atomic_get (&spi_flash_transferred_bytes);
+}
+
 int WrapperSpiCommandRead(void)
 {
 	return FLASH_CMD_READ;
@@ -123,6 +136,9 @@ int Wrapper_spi_flash_read (struct spi_flash *flash, uint32_t address, uint8_t *
 	FLASH_XFER_INIT_READ (xfer, FLASH_CMD_READ, address, read_dummy, read_mode, data, length, read_flags | addr_mode);
 	
 	status = SPI_Command_Xfer(flash,&xfer);
+	if (status == 0) {
+		atomic_add (&spi_flash_transferred_bytes, length);
+	}
 
 	return status;
 }
@@ -224,6 +240,7 @@ int Wrapper_spi_flash_write (struct spi_flash *flash, uint32_t address, const ui
 	}
 	
 	length = length - remaining;
+	atomic_add (&spi_flash_transferred_bytes, length);
 	
 	if (length) {
 		if (status != 0) {
@@ -281,6 +298,7 @@ int Wrapper_spi_flash_sector_erase (struct spi_flash *flash, uint32_t sector_add
 		return SPI_FLASH_INVALID_ARGUMENT;
 	}
 	xfer.cmd = MIDLEY_FLASH_CMD_4K_ERASE;
+	xfer.address = sector_addr;
 
     status = SPI_Command_Xfer(flash,&xfer);
 
@@ -330,6 +348,7 @@ int Wrapper_spi_flash_block_erase (struct spi_flash *flash, uint32_t block_addr)
 		return SPI_FLASH_INVALID_ARGUMENT;
 	}
 	xfer.cmd = MIDLEY_FLASH_CMD_64K_ERASE;
+	xfer.address = block_addr;
 
 	status = SPI_Command_Xfer(flash,&xfer);
 	
@@ -26,6 +26,7 @@ int Wrapper_spi_flash_get_block_size (struct spi_flash *flash, uint32_t *bytes);
 int Wrapper_spi_flash_block_erase (struct spi_flash *flash, uint32_t block_addr);
 int Wrapper_spi_flash_chip_erase (struct spi_flash *flash);
 uint32_t Wrapper_flash_master_capabilities (struct flash_master *spi);
+uint32_t Wrapper_spi_flash_transferred_bytes (void);
 
 
 #endif /* FLASH_WRAPPER_COMMON_H_ */
@@ -9,6 +9,7 @@
 #include "soc.h"
 
 #include <errno.h>
+#include <string.h>
 #include <drivers/i2c.h>
 #include <soc.h>
 
@@ -279,6 +280,21 @@ struct i2c_aspeed_config {
 	enum i2c_xfer_mode mode;
 };
 
+#ifdef CONFIG_I2C_SLAVE
+/*
+ * Transaction level slave callbacks.  When the slave owner provides them, DMA and buffer mode
+ * hand a whole master write over in one call and load a whole read response in one go instead
+ * of running the per byte i2c_slave_callbacks for every byte on the bus.  Byte mode keeps using
+ * the per byte callbacks.
+ */
+struct i2c_aspeed_slave_xfer_callbacks {
+	/* master write (command and payload) received, buf is only valid during the call */
+	int (*write_done)(struct i2c_slave_config *config, uint8_t *buf, uint32_t len);
+	/* master read, return the response to transmit */
+	int (*read_buffer)(struct i2c_slave_config *config, uint8_t **buf, uint32_t *len);
+};
+#endif
+
 struct i2c_aspeed_data {
 	struct k_sem sync_sem;
 	struct k_mutex trans_mutex;
@@ -318,6 +334,7 @@ struct i2c_aspeed_data {
 #ifdef CONFIG_I2C_SLAVE
 	unsigned char slave_dma_buf[I2C_SLAVE_BUF_SIZE];
 	struct i2c_slave_config *slave_cfg;
+	const struct i2c_aspeed_slave_xfer_callbacks *slave_xfer_cb;
 #endif
 };
 
@@ -1270,6 +1287,51 @@ static inline void aspeed_i2c_trigger_package_cmd(uint32_t i2c_base, uint8_t mod
 	sys_write32(cmd, i2c_base + AST_I2CS_CMD_STS);
 }
 
+/* hand the received packet, already in slave_dma_buf, to the transaction callback */
+static void aspeed_i2c_slave_xfer_write_done(struct i2c_aspeed_data *data, uint32_t slave_rx_len)
+{
+	if (slave_rx_len && data->slave_xfer_cb->write_done) {
+		data->slave_xfer_cb->write_done(data->slave_cfg
+		, data->slave_dma_buf, slave_rx_len);
+	}
+}
+
+/* fetch the read response from the transaction callback, returns the tx length */
+static uint32_t aspeed_i2c_slave_xfer_read(const struct device *dev)
+{
+	struct i2c_aspeed_config *config = DEV_CFG(dev);
+	struct i2c_aspeed_data *data = DEV_DATA(dev);
+	uint32_t max_len = (config->mode == DMA_MODE) ? I2C_SLAVE_BUF_SIZE : config->buf_size;
+	uint8_t *tx_buf = NULL;
+	uint32_t i, tx_len = 0;
+
+	if (data->slave_xfer_cb->read_buffer) {
+		data->slave_xfer_cb->read_buffer(data->slave_cfg, &tx_buf, &tx_len);
+	}
+
+	/* nothing to send, answer a single idle byte */
+	if (!tx_buf || !tx_len) {
+		data->slave_dma_buf[0] = 0xFF;
+		tx_buf = data->slave_dma_buf;
+		tx_len = 1;
+	}
+	tx_len = MIN(tx_len, max_len);
+
+	if (config->mode == DMA_MODE) {
+		if (tx_buf != data->slave_dma_buf) {
+			memcpy(data->slave_dma_buf, tx_buf, tx_len);
+		}
+		cache_data_range((&data->slave_dma_buf[0])
+		, tx_len, K_CACHE_WB);
+	} else {
+		for (i = 0; i < tx_len; i++) {
+			sys_write8(tx_buf[i], config->buf_base + i);
+		}
+	}
+
+	return tx_len;
+}
+
 void aspeed_i2c_slave_packet_irq(const struct device *dev, uint32_t i2c_base, uint32_t sts)
 {
 	struct i2c_aspeed_config *config = DEV_CFG(dev);
@@ -1277,6 +1339,7 @@ void aspeed_i2c_slave_packet_irq(const struct device *dev, uint32_t i2c_base, ui
 	const struct i2c_slave_callbacks *slave_cb = data->slave_cfg->callbacks;
 	uint32_t cmd = 0;
 	uint32_t i, slave_rx_len;
+	uint32_t tx_len = 1;
 	uint8_t byte_data, value;
 
 	/* clear irq first */
@@ -1335,6 +1398,10 @@ void aspeed_i2c_slave_packet_irq(const struct device *dev, uint32_t i2c_base, ui
 			/*aspeed_cache_invalid_data*/
 			cache_data_range((&data->slave_dma_buf[0])
 			, slave_rx_len, K_CACHE_INVD);
+			if (data->slave_xfer_cb) {
+				aspeed_i2c_slave_xfer_write_done(data, slave_rx_len);
+				slave_rx_len = 0;
+			}
 			for (i = 0; i < slave_rx_len; i++) {
 			/*LOG_DBG(data->dev, "[%02x]", data->slave_dma_buf[i]);*/
 				if (slave_cb->write_received) {
@@ -1349,7 +1416,12 @@ void aspeed_i2c_slave_packet_irq(const struct device *dev, uint32_t i2c_base, ui
 			cmd |= AST_I2CS_RX_BUFF_EN;
 			slave_rx_len =
 			AST_I2CC_GET_RX_BUF_LEN(sys_read32(i2c_base + AST_I2CC_BUFF_CTRL));
-			if (slave_cb->write_received) {
+			if (data->slave_xfer_cb) {
+				for (i = 0; i < slave_rx_len; i++) {
+					data->slave_dma_buf[i] = sys_read8(config->buf_base + i);
+				}
+				aspeed_i2c_slave_xfer_write_done(data, slave_rx_len);
+			} else if (slave_cb->write_received) {
 				for (i = 0; i < slave_rx_len ; i++) {
 					slave_cb->write_received(data->slave_cfg
 					, sys_read8(config->buf_base + i));
@@ -1396,6 +1468,14 @@ void aspeed_i2c_slave_packet_irq(const struct device *dev, uint32_t i2c_base, ui
 			slave_rx_len =
 			AST_I2C_GET_RX_DMA_LEN(sys_read32(i2c_base + AST_I2CS_DMA_LEN_STS));
 
+			if (data->slave_xfer_cb) {
+				cache_data_range((&data->slave_dma_buf[0])
+				, slave_rx_len, K_CACHE_INVD);
+				aspeed_i2c_slave_xfer_write_done(data, slave_rx_len);
+				tx_len = aspeed_i2c_slave_xfer_read(dev);
+				slave_rx_len = 0;
+			}
+
 			for (i = 0; i < slave_rx_len; i++) {
 				cache_data_range((&data->slave_dma_buf[i])
 				, 1, K_CACHE_INVD);
@@ -1406,7 +1486,7 @@ void aspeed_i2c_slave_packet_irq(const struct device *dev, uint32_t i2c_base, ui
 				}
 			}
 
-			if (slave_cb->read_requested) {
+			if (!data->slave_xfer_cb && slave_cb->read_requested) {
 				slave_cb->read_requested(data->slave_cfg
 				, &data->slave_dma_buf[0]);
 			}
@@ -1415,28 +1495,36 @@ void aspeed_i2c_slave_packet_irq(const struct device *dev, uint32_t i2c_base, ui
 			sys_write32(0, i2c_base + AST_I2CS_DMA_LEN_STS);
 			sys_write32((uint32_t)data->slave_dma_buf
 			, i2c_base + AST_I2CS_TX_DMA);
-			sys_write32(AST_I2CS_SET_TX_DMA_LEN(1)
+			sys_write32(AST_I2CS_SET_TX_DMA_LEN(tx_len)
 			, i2c_base + AST_I2CS_DMA_LEN);
 		} else if (config->mode == BUFF_MODE) {
 
 			cmd |= AST_I2CS_TX_BUFF_EN;
 			slave_rx_len =
 			AST_I2CC_GET_RX_BUF_LEN(sys_read32(i2c_base + AST_I2CC_BUFF_CTRL));
-			for (i = 0; i < slave_rx_len; i++) {
-				LOG_DBG("rx [%02x]", (sys_read32(config->buf_base + i) & 0xFF));
-				if (slave_cb->write_received) {
-					slave_cb->write_received(data->slave_cfg
-					, (sys_read32(config->buf_base + i) & 0xFF));
+			if (data->slave_xfer_cb) {
+				for (i = 0; i < slave_rx_len; i++) {
+					data->slave_dma_buf[i] = sys_read8(config->buf_base + i);
+				}
+				aspeed_i2c_slave_xfer_write_done(data, slave_rx_len);
+				tx_len = aspeed_i2c_slave_xfer_read(dev);
+			} else {
+				for (i = 0; i < slave_rx_len; i++) {
+					LOG_DBG("rx [%02x]", (sys_read32(config->buf_base + i) & 0xFF));
+					if (slave_cb->write_received) {
+						slave_cb->write_received(data->slave_cfg
+						, (sys_read32(config->buf_base + i) & 0xFF));
+					}
 				}
-			}
 
-			if (slave_cb->read_requested) {
-				slave_cb->read_requested(data->slave_cfg, &value);
-			}
-			LOG_DBG("tx [%02x]", value);
+				if (slave_cb->read_requested) {
+					slave_cb->read_requested(data->slave_cfg, &value);
+				}
+				LOG_DBG("tx [%02x]", value);
 
-			sys_write32(value, config->buf_base);
-			sys_write32(AST_I2CC_SET_TX_BUF_LEN(1)
+				sys_write32(value, config->buf_base);
+			}
+			sys_write32(AST_I2CC_SET_TX_BUF_LEN(tx_len)
 			, i2c_base + AST_I2CC_BUFF_CTRL);
 		} else {
 			cmd &= ~AST_I2CS_PKT_MODE_EN;
@@ -1462,23 +1550,29 @@ void aspeed_i2c_slave_packet_irq(const struct device *dev, uint32_t i2c_base, ui
 		cmd = SLAVE_TRIGGER_CMD;
 		if (config->mode == DMA_MODE) {
 			cmd |= AST_I2CS_TX_DMA_EN;
-			if (slave_cb->read_requested) {
+			if (data->slave_xfer_cb) {
+				tx_len = aspeed_i2c_slave_xfer_read(dev);
+			} else if (slave_cb->read_requested) {
 				slave_cb->read_requested(data->slave_cfg
 				, &data->slave_dma_buf[0]);
 			}
 			/*currently i2c slave framework only support one byte request.*/
 			LOG_DBG("tx: [%x]\n", data->slave_dma_buf[0]);
-			sys_write32(AST_I2CS_SET_TX_DMA_LEN(1)
+			sys_write32(AST_I2CS_SET_TX_DMA_LEN(tx_len)
 			, i2c_base + AST_I2CS_DMA_LEN);
 		} else if (config->mode == BUFF_MODE) {
 			cmd |= AST_I2CS_TX_BUFF_EN;
-			if (slave_cb->read_requested) {
-				slave_cb->read_requested(data->slave_cfg, &byte_data);
+			if (data->slave_xfer_cb) {
+				tx_len = aspeed_i2c_slave_xfer_read(dev);
+			} else {
+				if (slave_cb->read_requested) {
+					slave_cb->read_requested(data->slave_cfg, &byte_data);
+				}
+				/* currently i2c slave framework only support one byte request. */
+				LOG_DBG("tx : [%02x]", byte_data);
+				sys_write8(byte_data, config->buf_base);
 			}
-			/* currently i2c slave framework only support one byte request. */
-			LOG_DBG("tx : [%02x]", byte_data);
-			sys_write8(byte_data, config->buf_base);
-			sys_write32(AST_I2CC_SET_TX_BUF_LEN(1)
+			sys_write32(AST_I2CC_SET_TX_BUF_LEN(tx_len)
 			, i2c_base + AST_I2CC_BUFF_CTRL);
 		} else {
 			cmd &= ~AST_I2CS_PKT_MODE_EN;